@@ -11,7 +11,8 @@ extern "C" void __cxa_pure_virtual() {
 namespace __gnu_cxx {
 
   void __verbose_terminate_handler() {
-    //kernel::Thread::current()->kill();
+    if ( kernel::Thread::current() )
+      kernel::Thread::exit( 0 );
   }
 
 }
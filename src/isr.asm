@@ -1054,6 +1054,9 @@ isrwrapper:
   pushl %eax
   movl %cr3, %eax
   pushl %eax
+  # the kernel reaches its PerCPU area through gs, ring 3 had its own segment in it
+  movw $0x38, %ax
+  movw %ax, %gs
 
   pushl %esp # Save our stack position, so the following call will not mess with it.
   				 # And the other benefit is, we can easy, access the thread state by a pointer.
@@ -1086,3 +1089,45 @@ isrwrapper_delete_interrupt:
   add $4, %esp
 
 iret
+
+# The fast system call path, see kernel::SystemCall.
+# SYSENTER has loaded the kernel stack of the thread and disabled the interrupts,
+# the user stack is in ecx and the return address in edx.
+.global sysenter_entry
+.extern syscallback
+
+sysenter_entry:
+  pushl %gs
+  pushl %ecx
+  pushl %edx
+  pushl %edi
+  pushl %esi
+  pushl %ebx
+  pushl %eax
+  # the kernel runs without paging
+  movl %cr0, %eax
+  pushl %eax
+  andl $0x7fffffff, %eax
+  movl %eax, %cr0
+  movw $0x38, %ax # the PerCPU area
+  movw %ax, %gs
+
+  leal 4(%esp), %eax
+  pushl %eax # the SystemCall::Frame
+  sti
+  call syscallback
+  cli
+  add $4, %esp
+
+  popl %eax
+  movl %eax, %cr0
+  popl %eax # the result
+  popl %ebx
+  popl %esi
+  popl %edi
+  popl %edx
+  popl %ecx
+  popl %gs
+  # sti takes effect after sysexit, so we never run with interrupts in ring 0 here
+  sti
+  sysexit
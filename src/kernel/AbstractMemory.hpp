@@ -8,7 +8,7 @@
 #ifndef ABSTRACTMEMORY_HPP_
 #define ABSTRACTMEMORY_HPP_
 
-#include <lib/sync/Mutex.hpp>
+#include <lib/sync/MCSLock.hpp>
 #include <lib/collection/RawAAMap.hpp>
 
 namespace kernel {
@@ -44,7 +44,7 @@ namespace kernel {
     public:
       uint32 memsize; ///< Size of the usable memory in byte.
       uint32 memused; ///< Size of the used memory in byte.
-      lib::sync::Mutex mutex;
+      lib::sync::MCSLock lock; ///< Held only for the short map updates, never while clearing memory or throwing.
       lib::collection::RawAAMap addresses;
       lib::collection::RawAAMap sizes;
 
@@ -0,0 +1,199 @@
+/**
+ * Benchmark.cpp
+ *
+ * @since 19.10.2026
+ * @author Arne Simon => email::[arne_simon@gmx.de]
+ */
+
+#include "Benchmark.hpp"
+#include <kernel/System.hpp>
+#include <kernel/Thread.hpp>
+#include <kernel/driver/AHCI.hpp>
+#include <kernel/driver/VirtioBlock.hpp>
+#include <lib/sync/Atomic.hpp>
+#include <lib/Syscall.hpp>
+#include <lib/std.hpp>
+
+namespace kernel {
+
+  lib::sync::Mutex Benchmark::mutex;
+  uint32 Benchmark::shared = 0;
+  driver::BlockDevice* Benchmark::ata = 0;
+  driver::BlockDevice* Benchmark::device = 0;
+  uint32 Benchmark::reads = 0;
+  volatile uint32 Benchmark::done = 0;
+
+  void Benchmark::start( MultiBoot* mb, driver::BlockDevice* drive ) {
+    if ( not ( mb->flags & 0x04 ) || not lib::strstr( ( const char* ) mb->cmdline, "benchmark" ) )
+      return;
+
+    ata = drive;
+
+    new Thread( system, ( uint32 ) &Benchmark::execute, Thread::DefaultStackSize );
+  }
+
+  uint32 Benchmark::divide( uint64 n, uint32 d ) {
+    uint32 q, r;
+
+    if ( d == 0 )
+      return 0;
+
+    asm volatile("divl %4": "=a"(q), "=d"(r): "0"(( uint32 ) n), "1"(( uint32 ) ( n >> 32 )), "r"(d));
+
+    return q;
+  }
+
+  void Benchmark::parallel( uint32 func, uint32 threads ) {
+    Thread* t[ 8 ];
+
+    threads = lib::min( threads, ( uint32 ) 8 );
+
+    for ( uint32 i = 0; i < threads; ++i )
+      t[ i ] = new Thread( system, func, Thread::DefaultStackSize );
+
+    for ( uint32 i = 0; i < threads; ++i )
+      t[ i ]->join();
+  }
+
+  void* Benchmark::hammer() {
+    for ( uint32 i = 0; i < HammerRounds; ++i ) {
+      mutex.enter();
+      shared++;
+      mutex.leave();
+    }
+
+    return 0;
+  }
+
+  void Benchmark::contention() {
+    uint32 contended = mutex.contended;
+
+    shared = 0;
+
+    uint64 start = lib::rdtsc();
+
+    parallel( ( uint32 ) &Benchmark::hammer, Hammers );
+
+    uint64 cycles = lib::rdtsc() - start;
+
+    system->video << "mutex: contended " << mutex.contended - contended << " of " << shared;
+    system->video << ", " << divide( cycles, shared ) << " cycles/enter\n";
+  }
+
+  void Benchmark::clock() {
+    const uint32 rounds = 100000;
+    uint64 start = lib::rdtsc();
+
+    for ( uint32 i = 0; i < rounds; ++i )
+      system->shared->now();
+
+    uint64 page = lib::rdtsc() - start;
+
+    start = lib::rdtsc();
+
+    for ( uint32 i = 0; i < rounds; ++i )
+      lib::Syscall::trap( lib::Syscall::Nop );
+
+    uint64 trap = lib::rdtsc() - start;
+
+    system->video << "clock: page " << divide( page, rounds ) << " cycles/read, ";
+    system->video << "int " << divide( trap, rounds ) << " cycles/call\n";
+  }
+
+  void Benchmark::cpu( driver::BlockDevice* d ) {
+    uint8* buffer = ( uint8* ) System::physical_memory.alloc();
+    uint32 sectors = ( uint32 ) lib::min( d->size, ( uint64 ) 131072 ) & ~7;
+    Thread* self = Thread::current();
+    bool irq = lib::cli();
+
+    self->account( false );
+
+    uint64 busy = self->usage.kernel + self->usage.user;
+
+    if ( irq )
+      lib::sti();
+
+    uint64 start = lib::rdtsc();
+
+    for ( uint32 lba = 0; lba < sectors; lba += 8 )
+      d->readSector( 8, lba, buffer );
+
+    uint64 elapsed = lib::rdtsc() - start;
+
+    irq = lib::cli();
+
+    self->account( false );
+    busy = self->usage.kernel + self->usage.user - busy;
+
+    if ( irq )
+      lib::sti();
+
+    System::physical_memory.free( buffer );
+
+    system->video << "cpu: " << ( uint32 ) ( busy >> 20 ) << " of " << ( uint32 ) ( elapsed >> 20 );
+    system->video << " MCycles for " << sectors / 2048 << " MByte\n";
+  }
+
+  void* Benchmark::reader() {
+    uint8* buffer = ( uint8* ) System::physical_memory.alloc();
+    uint32 blocks = ( uint32 ) lib::min( device->size >> 3, ( uint64 ) 0xFFFFFFFF );
+    uint32 seed = Thread::current()->id();
+
+    for ( uint32 i = 0; i < reads; ++i ) {
+      seed = seed * 1103515245 + 12345;
+      device->readSector( 8, ( uint64 ) ( ( seed >> 8 ) % blocks ) << 3, buffer );
+    }
+
+    lib::sync::fetch_add( &done, reads );
+
+    System::physical_memory.free( buffer );
+
+    return 0;
+  }
+
+  uint32 Benchmark::iops( driver::BlockDevice* d, uint32 threads, uint32 rounds ) {
+    if ( d->size < 8 )
+      return 0;
+
+    device = d;
+    reads = rounds;
+    done = 0;
+
+    uint64 start = lib::rdtsc();
+
+    parallel( ( uint32 ) &Benchmark::reader, threads );
+
+    uint32 ms = divide( lib::rdtsc() - start, system->shared->tsc_khz );
+
+    return divide( ( uint64 ) done * 1000, ms );
+  }
+
+  void* Benchmark::execute() {
+    contention();
+    clock();
+
+    if ( ata )
+      cpu( ata );
+
+    if ( system->ahci ) {
+      for ( uint32 i = 0; i < 32; ++i ) {
+        if ( system->ahci->ports[ i ] ) {
+          system->video << "ahci: " << iops( system->ahci->ports[ i ], 8, 10000 ) << " IOPS\n";
+          break;
+        }
+      }
+    }
+
+    if ( system->virtio && system->virtio->queue_count ) {
+      driver::VirtioBlock::Queue& q = system->virtio->queues[ 0 ];
+      uint32 submitted = q.submitted;
+      uint32 notifications = q.notifications;
+
+      system->video << "virtio: " << iops( system->virtio, 4, 25000 ) << " IOPS, notifications ";
+      system->video << q.notifications - notifications << " of " << q.submitted - submitted << "\n";
+    }
+
+    return 0;
+  }
+
+}
@@ -0,0 +1,105 @@
+/**
+ * Benchmark.hpp
+ *
+ * @since 19.10.2026
+ * @author Arne Simon => email::[arne_simon@gmx.de]
+ */
+
+#ifndef KERNEL_BENCHMARK_HPP_
+#define KERNEL_BENCHMARK_HPP_
+
+#include <cpp.hpp>
+#include <MultiBoot.hpp>
+#include <lib/sync/Mutex.hpp>
+
+namespace kernel {
+
+  namespace driver {
+    class BlockDevice;
+  }
+
+  /**
+   * The measurements of the kernel, each prints one line.
+   *
+   * main() starts them in a thread of their own, if GRUB passes
+   * "benchmark" on the kernel command line. They need the scheduler and
+   * the interrupts, so they run after the boot is done:
+   * <ul>
+   *  <li>contention() - four threads hammer one lib::sync::Mutex</li>
+   *  <li>clock() - the lib::SharedPage clock against an empty system call</li>
+   *  <li>cpu() - the cpu time an ATA drive costs a sequential reader</li>
+   *  <li>iops() - parallel random reads, e.g. NCQ of AHCI or virtqueue batching</li>
+   * </ul>
+   *
+   * @code
+   * kernel ( hd0,0 )/boot/platin benchmark
+   * @endcode
+   *
+   * @since 19.10.2026
+   * @author Arne Simon => email::[arne_simon@gmx.de]
+   */
+  class Benchmark {
+    protected:
+      static const uint32 Hammers = 4;
+      static const uint32 HammerRounds = 100000;
+
+      static lib::sync::Mutex mutex; ///< The mutex of contention().
+      static uint32 shared; ///< Guarded by mutex.
+      static driver::BlockDevice* ata; ///< The drive of cpu(), or null.
+      static driver::BlockDevice* device; ///< The drive of the readers.
+      static uint32 reads; ///< Reads per reader.
+      static volatile uint32 done; ///< Reads of all readers.
+
+      static void* hammer();
+
+      static void* reader();
+
+      /**
+       * Runs a function in some threads and waits for them.
+       */
+      static void parallel( uint32 func, uint32 threads );
+
+      /**
+       * Divides with one divl, the quotient has to fit into 32 bit.
+       */
+      static uint32 divide( uint64 n, uint32 d );
+
+      /**
+       * Runs every benchmark the hardware allows.
+       */
+      static void* execute();
+
+    public:
+      /**
+       * Starts the benchmark thread, if the command line asks for it.
+       *
+       * @param mb The multiboot structure from GRUB.
+       * @param drive An ATA drive for cpu(), may be null.
+       */
+      static void start( MultiBoot* mb, driver::BlockDevice* drive );
+
+      static void contention();
+
+      /**
+       * Reads the clock from the page and calls lib::Syscall::Nop through
+       * the interrupt gate, SYSEXIT only returns to ring 3.
+       */
+      static void clock();
+
+      /**
+       * Reads up to 64 MByte sequentially and compares the cpu time
+       * charged to the reader with the elapsed time.
+       */
+      static void cpu( driver::BlockDevice* d );
+
+      /**
+       * Some threads read random 4 KByte blocks.
+       *
+       * @return The reads per second.
+       */
+      static uint32 iops( driver::BlockDevice* d, uint32 threads, uint32 rounds );
+  };
+
+}
+
+#endif /* KERNEL_BENCHMARK_HPP_ */
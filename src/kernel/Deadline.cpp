@@ -0,0 +1,190 @@
+/**
+ * Deadline.cpp
+ *
+ * @since 19.10.2026
+ * @author Arne Simon => email::[arne_simon@gmx.de]
+ */
+
+#include "Deadline.hpp"
+#include <kernel/System.hpp>
+#include <kernel/Thread.hpp>
+#include <lib/std.hpp>
+
+namespace kernel {
+
+  Thread* Deadline::threads = 0;
+  uint32 Deadline::utilization = 0;
+  bool Deadline::oneshot = false;
+  uint32 Deadline::overruns = 0;
+  uint32 Deadline::misses = 0;
+
+  /**
+   * The longest alarm, it fits the 16 bit counter of the PIT.
+   */
+  static const uint32 MaxAlarm = 50000;
+
+  void Deadline::alarm( uint64 cycles ) {
+    uint32 mhz = system->shared->tsc_khz / 1000;
+
+    if ( cycles > ( uint64 ) MaxAlarm * mhz )
+      cycles = ( uint64 ) MaxAlarm * mhz;
+
+    uint32 ticks = ( uint32 ) cycles / mhz * ( PIT::Frequency / 1000 ) / 1000;
+
+    if ( ticks == 0 )
+      ticks = 1;
+
+    system->timer.init( PIT::Mod_TerminalCount );
+    system->timer.load( ticks );
+    oneshot = true;
+  }
+
+  void Deadline::periodic() {
+    if ( not oneshot )
+      return;
+
+    system->timer.init( PIT::Mod_RateGenerator );
+    system->timer.load( PIT::Tick );
+    oneshot = false;
+  }
+
+  bool Deadline::admit( Thread* t, uint32 runtime, uint32 period, uint32 deadline ) {
+    uint32 mhz = system->shared->tsc_khz / 1000;
+
+    if ( mhz == 0 || runtime == 0 || runtime > deadline || deadline > period || period > MaxPeriod )
+      return false;
+
+    uint32 u = runtime * Scale / period;
+    bool irq = lib::cli();
+    Reservation& r = t->realtime;
+    uint32 others = utilization - r.utilization;
+
+    if ( others + u > Bound ) {
+      if ( irq )
+        lib::sti();
+      return false;
+    }
+
+    if ( r.runtime == 0 ) {
+      r.next = threads;
+      threads = t;
+    }
+
+    utilization = others + u;
+
+    uint64 now = lib::rdtsc();
+
+    r.runtime = ( uint64 ) runtime * mhz;
+    r.period = ( uint64 ) period * mhz;
+    r.deadline = ( uint64 ) deadline * mhz;
+    r.budget = r.runtime;
+    r.release = now + r.period;
+    r.absolute = now + r.deadline;
+    r.started = now;
+    r.utilization = u;
+
+    if ( irq )
+      lib::sti();
+
+    return true;
+  }
+
+  void Deadline::leave( Thread* t ) {
+    bool irq = lib::cli();
+    Reservation& r = t->realtime;
+
+    if ( r.runtime ) {
+      Thread** i = &threads;
+
+      while ( *i && *i != t ) {
+        i = &( *i )->realtime.next;
+      }
+
+      if ( *i )
+        *i = r.next;
+
+      utilization -= r.utilization;
+      lib::memset( &r, 0, sizeof(Reservation) );
+
+      if ( threads == 0 )
+        periodic();
+    }
+
+    if ( irq )
+      lib::sti();
+  }
+
+  Thread* Deadline::pick( Thread* c, uint64 now ) {
+    if ( threads == 0 )
+      return 0;
+
+    Reservation& r = c->realtime;
+
+    if ( r.runtime && r.budget ) {
+      uint64 ran = now - r.started;
+
+      r.budget = ran < r.budget ? r.budget - ran : 0;
+
+      if ( c->yielded && c->mode == Thread::READY )
+        r.budget = 0; // done for this period
+      else if ( r.budget == 0 )
+        overruns++;
+    }
+
+    Thread* best = 0;
+
+    for ( Thread* t = threads; t; t = t->realtime.next ) {
+      Reservation& s = t->realtime;
+
+      if ( now >= s.release ) {
+        if ( s.budget && t->mode == Thread::READY )
+          misses++;
+
+        // a thread which slept for whole periods starts a fresh one
+        if ( now - s.release >= s.period )
+          s.release = now;
+
+        s.budget = s.runtime;
+        s.absolute = s.release + s.deadline;
+        s.release += s.period;
+      }
+
+      if ( s.budget && ( t->mode == Thread::READY || t->mode == Thread::START )
+          && ( best == 0 || s.absolute < best->realtime.absolute ) )
+        best = t;
+    }
+
+    return best;
+  }
+
+  void Deadline::arm( Thread* n, uint64 now ) {
+    if ( threads == 0 ) {
+      periodic();
+      return;
+    }
+
+    uint64 next;
+
+    if ( n->realtime.runtime ) {
+      n->realtime.started = now;
+      next = n->realtime.budget;
+    }
+    else {
+      // a time sharing thread gets the slice of the periodic tick
+      uint32 mhz = system->shared->tsc_khz / 1000;
+
+      next = ( uint64 ) ( PIT::Tick * 1000 / ( PIT::Frequency / 1000 ) ) * mhz;
+    }
+
+    // a release may bring a thread with an earlier deadline
+    for ( Thread* t = threads; t; t = t->realtime.next ) {
+      uint64 wait = t->realtime.release > now ? t->realtime.release - now : 0;
+
+      if ( wait < next )
+        next = wait;
+    }
+
+    alarm( next );
+  }
+
+}
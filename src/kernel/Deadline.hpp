@@ -0,0 +1,130 @@
+/**
+ * Deadline.hpp
+ *
+ * @since 19.10.2026
+ * @author Arne Simon => email::[arne_simon@gmx.de]
+ */
+
+#ifndef KERNEL_DEADLINE_HPP_
+#define KERNEL_DEADLINE_HPP_
+
+#include <cpp.hpp>
+
+namespace kernel {
+
+  class Thread;
+
+  /**
+   * The earliest deadline first scheduling class.
+   *
+   * A thread reserves a runtime every period, which it gets within its
+   * relative deadline. Each reservation is a server: at every release its
+   * budget is refilled to the runtime and its absolute deadline moves one
+   * period on. The dispatcher runs the admitted thread with the earliest
+   * absolute deadline and budget left before any thread of the time
+   * sharing class. A thread which used up its budget is throttled until
+   * its next release, so it can not starve the time sharing class.
+   *
+   * Admission control keeps the summed runtime/period of all reservations
+   * below Bound, so every admitted thread meets its deadlines, as long as
+   * the deadlines equal the periods.
+   *
+   * While reservations exist, the dispatcher arms the PIT for the end of
+   * the budget of the running thread or the next release, whichever comes
+   * first, so the budgets are enforced and releases preempt the time
+   * sharing class. A time sharing thread runs at most one PIT::Tick, and
+   * once the last reservation left, the PIT ticks periodically again.
+   *
+   * @code
+   * void* control() {
+   *   while ( true ) {
+   *     // read the sensors, drive the actors
+   *     kernel::Thread::yield(); // done for this period
+   *   }
+   * }
+   *
+   * kernel::Thread* t = new kernel::Thread( system, ( uint32 ) &control, kernel::Thread::DefaultStackSize );
+   *
+   * // 2 ms every 10 ms, within 5 ms
+   * if ( not kernel::Deadline::admit( t, 2000, 10000, 5000 ) )
+   *   system->video << "rejected, the cpu is booked out\n";
+   * @endcode
+   *
+   * @since 19.10.2026
+   * @author Arne Simon => email::[arne_simon@gmx.de]
+   */
+  class Deadline {
+    public:
+      /**
+       * The reservation of a thread, all times in TSC cycles.
+       */
+      struct Reservation {
+          uint64 runtime; ///< The budget of every period, 0 for the time sharing class.
+          uint64 period;
+          uint64 deadline; ///< Relative to the release.
+          uint64 budget; ///< What is left of the runtime in this period.
+          uint64 release; ///< The start of the next period.
+          uint64 absolute; ///< The deadline of this period.
+          uint64 started; ///< When the thread was dispatched the last time.
+          uint32 utilization; ///< runtime/period in 1/Scale.
+          Thread* next; ///< The next admitted thread.
+      };
+
+      static const uint32 Scale = 1024;
+      static const uint32 Bound = 922; ///< 90% of the cpu, the rest is left to the time sharing class.
+      static const uint32 MaxPeriod = 4000000; ///< Four seconds in microseconds.
+
+    protected:
+      static Thread* threads; ///< The admitted threads.
+      static uint32 utilization; ///< The sum of the admitted reservations.
+      static bool oneshot; ///< The PIT runs in terminal count mode, armed by alarm().
+
+      /**
+       * Arms the PIT in terminal count mode.
+       */
+      static void alarm( uint64 cycles );
+
+      /**
+       * Returns the PIT to the periodic time sharing tick, once the last reservation is gone.
+       */
+      static void periodic();
+
+    public:
+      static uint32 overruns; ///< How often a thread was throttled.
+      static uint32 misses; ///< How often a thread had budget left at its deadline.
+
+      /**
+       * Moves a thread into the deadline class.
+       *
+       * @param t The thread, which may not have a reservation yet.
+       * @param runtime The cpu time per period in microseconds.
+       * @param period The period in microseconds, at most MaxPeriod.
+       * @param deadline The relative deadline in microseconds, between runtime and period.
+       * @return False if the reservation would overload the cpu or is invalid.
+       */
+      static bool admit( Thread* t, uint32 runtime, uint32 period, uint32 deadline );
+
+      /**
+       * Moves a thread back into the time sharing class.
+       */
+      static void leave( Thread* t );
+
+      /**
+       * Charges the budget of the outgoing thread, refills the released
+       * reservations and picks the next thread.
+       *
+       * @param c The outgoing thread.
+       * @param now The TSC of the dispatch.
+       * @return The runnable thread with the earliest deadline and budget left, or null.
+       */
+      static Thread* pick( Thread* c, uint64 now );
+
+      /**
+       * Notes the dispatch and arms the PIT for the next scheduling event.
+       */
+      static void arm( Thread* n, uint64 now );
+  };
+
+}
+
+#endif /* KERNEL_DEADLINE_HPP_ */
@@ -0,0 +1,105 @@
+/**
+ * Futex.cpp
+ *
+ * @since 19.10.2026
+ * @author Arne Simon => email::[arne_simon@gmx.de]
+ */
+
+#include "Futex.hpp"
+#include <kernel/System.hpp>
+#include <lib/sync/Atomic.hpp>
+#include <lib/std.hpp>
+
+namespace kernel {
+
+  Futex::Bucket Futex::buckets[ BucketCount ];
+
+  uint32 Futex::key( volatile uint32* address ) {
+    Thread* t = Thread::current();
+    uint32 cr0;
+
+    asm volatile("mov %%cr0, %0": "=r"(cr0));
+
+    // without paging the address is already physical, e.g. in a system call
+    if ( t && ( cr0 & 0x80000000 ) )
+      return t->process()->virtual_memory.getPhysicalAddress( ( uint32 ) address );
+
+    return ( uint32 ) address;
+  }
+
+  Futex::Bucket& Futex::bucket( uint32 key ) {
+    // the lowest two bits are always zero for aligned words
+    return buckets[ ( ( key >> 2 ) ^ ( key >> 12 ) ) % BucketCount ];
+  }
+
+  bool Futex::wait( volatile uint32* address, uint32 expected ) {
+    Thread* self = Thread::current();
+    bool irq = lib::cli();
+
+    // we can not be parked, but int $0x20 still dispatches the waker
+    if ( self == 0 || not irq ) {
+      if ( irq )
+        lib::sti();
+
+      if ( self )
+        Thread::yield();
+      else
+        lib::sync::relax();
+
+      return *address == expected;
+    }
+
+    uint32 k = key( address );
+    Bucket& b = bucket( k );
+
+    b.lock.enter();
+
+    // the value check and the enqueuing are atomic to wake()
+    if ( *address != expected ) {
+      b.lock.leave();
+      lib::sti();
+      return false;
+    }
+
+    self->futex_key = k;
+    b.waiters.push( self );
+    self->mode = Thread::BLOCKED;
+
+    b.lock.leave();
+
+    do {
+      Thread::yield();
+    } while ( self->mode == Thread::BLOCKED );
+
+    lib::sti();
+
+    return true;
+  }
+
+  uint32 Futex::wake( volatile uint32* address, uint32 count ) {
+    uint32 k = key( address );
+    Bucket& b = bucket( k );
+    uint32 woken = 0;
+
+    b.lock.enter();
+
+    Thread* t = b.waiters.first();
+
+    while ( t && woken < count ) {
+      Thread* n = t->wait_next;
+
+      if ( t->futex_key == k ) {
+        b.waiters.remove( t );
+        t->wakeup();
+        woken++;
+      }
+
+      t = n;
+    }
+
+    b.lock.leave();
+
+    return woken;
+  }
+
+}
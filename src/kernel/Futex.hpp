@@ -0,0 +1,96 @@
+/**
+ * Futex.hpp
+ *
+ * @since 19.10.2026
+ * @author Arne Simon => email::[arne_simon@gmx.de]
+ */
+
+#ifndef KERNEL_FUTEX_HPP_
+#define KERNEL_FUTEX_HPP_
+
+#include <cpp.hpp>
+#include <lib/sync/WaitQueue.hpp>
+#include <lib/sync/TicketLock.hpp>
+
+namespace kernel {
+
+  class Thread;
+
+  /**
+   * Fast user space mutex, the blocking primitive of the kernel.
+   *
+   * A futex is nothing but an aligned 32 bit word. The synchronisation
+   * objects do their uncontended work with atomic operations on that word,
+   * only if they have to wait or there are waiters to wake, they call into
+   * the Futex.
+   *
+   * Waiters are keyed by the physical address of the word, so two processes
+   * sharing a page wait on the same futex, regardless of the virtual
+   * addresses they use.
+   *
+   * @code
+   * volatile uint32 flag = 0;
+   *
+   * // waiter
+   * while ( flag == 0 )
+   *   kernel::Futex::wait( &flag, 0 );
+   *
+   * // waker
+   * flag = 1;
+   * kernel::Futex::wake( &flag, kernel::Futex::All );
+   * @endcode
+   *
+   * @note http://www.akkadia.org/drepper/futex.pdf
+   *
+   * @since 19.10.2026
+   * @author Arne Simon => email::[arne_simon@gmx.de]
+   */
+  class Futex {
+    protected:
+      static const uint32 BucketCount = 64;
+
+      struct Bucket {
+          lib::sync::TicketLock lock;
+          lib::sync::WaitQueue waiters;
+      };
+
+      static Bucket buckets[ BucketCount ];
+
+      /**
+       * Calculates the key of a futex word.
+       *
+       * @return The physical address of the word.
+       */
+      static uint32 key( volatile uint32* address );
+
+      static Bucket& bucket( uint32 key );
+
+    public:
+      static const uint32 All = 0xffffffff; ///< Wakes every waiter.
+
+      /**
+       * Blocks the current thread, if the word still contains the expected value.
+       *
+       * @attention The caller has to recheck its condition after wait returns,
+       *    the thread could have been woken for another reason or could not be
+       *    parked at all, because there is no scheduler yet or the interrupts are off.
+       *
+       * @param address The futex word.
+       * @param expected The value the caller last saw.
+       * @return False if the word did not contain the expected value.
+       */
+      static bool wait( volatile uint32* address, uint32 expected );
+
+      /**
+       * Wakes threads waiting on a futex word.
+       *
+       * @param address The futex word.
+       * @param count The maximal number of threads to wake.
+       * @return The number of woken threads.
+       */
+      static uint32 wake( volatile uint32* address, uint32 count );
+  };
+
+}
+
+#endif /* KERNEL_FUTEX_HPP_ */
@@ -8,14 +8,53 @@
 #ifndef ISR_HPP_
 #define ISR_HPP_
 
+#include <cpp.hpp>
+
 namespace kernel {
 
   /**
    * An interface for a interrupt service routine.
+   *
+   * The routine is split in two halves. The top half call() runs in the
+   * interrupt with the interrupts disabled, it should only acknowledge the
+   * device and hand the rest over with System::defer(). The bottom half
+   * work() runs later in an InterruptHandler thread.
+   *
+   * @code
+   * bool call() {
+   *   uint8 status = lib::inb( port );
+   *
+   *   if ( not ( status & Pending ) )
+   *     return false; // not our device
+   *
+   *   system->defer( this, status );
+   *   return true;
+   * }
+   *
+   * void work( uint32 status ) {
+   *   // the slow part
+   * }
+   * @endcode
    */
   class ISR {
     public:
+      /**
+       * The top half.
+       *
+       * @return True if the interrupt was raised by the device of this routine.
+       */
       virtual bool call() = 0;
+
+      /**
+       * The bottom half.
+       *
+       * @param data The value the top half passed to System::defer().
+       */
+      virtual void work( uint32 /*data*/ ) {
+      }
+
+      virtual ~ISR() {
+      }
   };
 
 }
@@ -11,28 +11,17 @@
 namespace kernel {
 
   InterruptHandler::InterruptHandler()
-      : Thread( system ) {
-    behavior.priority = 20;
+      : Thread( system, ( uint32 ) &InterruptHandler::execute, DefaultStackSize ) {
+    behavior.priority = Priority;
   }
 
   void* InterruptHandler::execute() {
-    System::ISRList *hlist;
-    System::ISRList::Iterator* iter;
-    uint8 irq;
+    WorkQueue& queue = system->work[ System::cpu() ];
 
     while ( true ) {
-      while ( system->interrupts.size() ) { // got we any interrupts ?
-        irq = system->interrupts.pop();
-
-        hlist = &system->isr[ irq ]; // get array of interrupt handlers
-
-        for ( iter = hlist->iterator(); *iter; ++( *iter ) ) { // call each interrupt handler
-          ( **iter )->call();
-        }
-        delete iter;
-
-      }
-      yield(); // we do not need the cpu anymore
+      // after a full batch the normal threads get their turn
+      if ( queue.drain() == WorkQueue::Batch )
+        yieldLower();
     }
 
     return 0;
@@ -14,12 +14,17 @@ namespace kernel {
 
   /**
    * Handles the fetched interrupts.
+   *
+   * The worker thread of a cpu, which runs the bottom halves deferred by
+   * the interrupts of its cpu, see WorkQueue.
    */
   class InterruptHandler: public Thread {
     public:
+      static const uint8 Priority = 20;
+
       InterruptHandler();
 
-      void* execute();
+      static void* execute();
   };
 
 }
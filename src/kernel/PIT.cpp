@@ -17,7 +17,7 @@ namespace kernel {
 
   void PIT::init( uint8 mode ) {
     // 0x30 = write least significant byte, then most significant byte !
-    lib::outb( Init, ( ( channel & 0xFC ) << 6 ) | mode | 0x30 );
+    lib::outb( Init, ( ( channel & 0x03 ) << 6 ) | mode | 0x30 );
   }
 
   void PIT::load( uint16 counter ) {
@@ -25,4 +25,24 @@ namespace kernel {
     lib::outb( channel, counter >> 8 ); // write MSB.
   }
 
+  uint32 PIT::calibrate() {
+    PIT speaker( Channel2 );
+
+    // open the gate of channel 2, but keep the speaker silent
+    lib::outb( Gate, ( lib::inb( Gate ) & ~0x02 ) | 0x01 );
+
+    speaker.init( Mod_TerminalCount );
+    speaker.load( CalibrationCount );
+
+    uint64 start = lib::rdtsc();
+
+    // the output goes high at the terminal count
+    while ( not ( lib::inb( Gate ) & 0x20 ) ) {
+    }
+
+    uint32 cycles = ( uint32 ) ( lib::rdtsc() - start );
+
+    return cycles / ( CalibrationCount * 1000 / Frequency ); // cycles per millisecond
+  }
+
 }
@@ -30,6 +30,11 @@ namespace kernel {
       const static uint8 Channel1 = 0x41; ///< Counter Channel 1. Used in early days for memory sync.
       const static uint8 Channel2 = 0x42; ///< Counter Channel 2. Linked to the system-speaker.
       const static uint8 Init = 0x43; ///< Init
+      const static uint8 Gate = 0x61; ///< Gate of channel 2 (bit 0), speaker (bit 1) and output of channel 2 (bit 5).
+
+      const static uint32 Frequency = 1193182; ///< The input clock of all channels in Hz.
+      const static uint16 CalibrationCount = 11932; ///< 10 milliseconds of the input clock.
+      const static uint16 Tick = 6000; ///< The reload of the time sharing tick, about 5 milliseconds.
 
       const static uint8 Mod_TerminalCount = 0; ///< Interrupt on terminal count.
       const static uint8 Mod_Retrigger = 0x02; ///< Hardware Retriggerable One-Shot.
@@ -53,6 +58,15 @@ namespace kernel {
        */
       void load( uint16 counter );
 
+      /**
+       * Measures the frequency of the time stamp counter against channel 2.
+       *
+       * @attention Has to run with interrupts off, takes 10 milliseconds.
+       *
+       * @return The TSC frequency in kHz.
+       */
+      static uint32 calibrate();
+
   };
 
 }
@@ -0,0 +1,24 @@
+/**
+ * PerCPU.cpp
+ *
+ * @since 19.10.2026
+ * @author Arne Simon => email::[arne_simon@gmx.de]
+ */
+
+#include "PerCPU.hpp"
+#include <kernel/System.hpp>
+#include <lib/std.hpp>
+
+namespace kernel {
+
+  PerCPU PerCPU::areas[ System::MaxCPUs ];
+
+  void PerCPU::setup( uint32 cpu ) {
+    PerCPU& a = areas[ cpu ];
+
+    lib::memset( &a, 0, sizeof(PerCPU) );
+    a.self = &a;
+    a.cpu_id = cpu;
+  }
+
+}
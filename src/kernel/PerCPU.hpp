@@ -0,0 +1,124 @@
+/**
+ * PerCPU.hpp
+ *
+ * @since 19.10.2026
+ * @author Arne Simon => email::[arne_simon@gmx.de]
+ */
+
+#ifndef KERNEL_PERCPU_HPP_
+#define KERNEL_PERCPU_HPP_
+
+#include <cpp.hpp>
+
+namespace kernel {
+
+  class Thread;
+  class Process;
+
+  /**
+   * The data every cpu owns alone.
+   *
+   * Each cpu has a GDT entry whose base is its PerCPU area and keeps it
+   * loaded in GS while it runs kernel code. The interrupt wrappers and the
+   * SYSENTER path reload GS, because ring 3 has its own data segment in it.
+   *
+   * A field is read with a single GS relative mov, without locks and
+   * without chasing the scheduling plan:
+   * @code
+   * Thread* t = PerCPU::thread();
+   * uint32 n = PerCPU::read< uint32, __builtin_offsetof( PerCPU, thread_count ) >();
+   * @endcode
+   *
+   * Only the owning cpu writes its area, with the interrupts off if an
+   * interrupt handler uses the same field.
+   *
+   * @since 19.10.2026
+   * @author Arne Simon => email::[arne_simon@gmx.de]
+   */
+  class PerCPU {
+    public:
+      static const uint32 CacheSize = 16; ///< Cached thread objects and stacks, see Reaper.
+
+      PerCPU* self; ///< The linear address of the area, the base of the GS segment.
+      Thread* current_thread; ///< The running thread.
+      Process* current_process; ///< The process of the running thread.
+      uint32 cpu_id;
+
+      //--- Allocator caches of the Reaper ---
+
+      void* threads[ CacheSize ];
+      uint32 thread_count;
+      uint8* stacks[ CacheSize ];
+      uint32 stack_count;
+
+      static PerCPU areas[]; ///< One area per cpu, indexed by the cpu number.
+
+      /**
+       * Reads a field of the area of the executing cpu.
+       *
+       * @tparam T The type of the field, at most 32 bit.
+       * @tparam Offset The offset of the field in PerCPU.
+       */
+      template< typename T, uint32 Offset >
+      static T read() {
+        T v;
+
+        asm volatile("mov %%gs:%c1, %0": "=r"(v): "i"(Offset));
+
+        return v;
+      }
+
+      /**
+       * Writes a field of the area of the executing cpu.
+       */
+      template< typename T, uint32 Offset >
+      static void write( T v ) {
+        asm volatile("mov %0, %%gs:%c1":: "r"(v), "i"(Offset): "memory");
+      }
+
+      /**
+       * @return The area of the executing cpu.
+       */
+      static PerCPU* local();
+
+      static Thread* thread();
+
+      static Process* process();
+
+      static uint32 id();
+
+      /**
+       * Sets the running thread, called by the dispatcher.
+       */
+      static void enter( Thread* t, Process* p );
+
+      /**
+       * Prepares the area of a cpu before its GDT entry is loaded.
+       */
+      static void setup( uint32 cpu );
+  };
+
+  inline PerCPU* PerCPU::local() {
+    return read< PerCPU*, __builtin_offsetof( PerCPU, self ) >();
+  }
+
+  inline Thread* PerCPU::thread() {
+    return read< Thread*, __builtin_offsetof( PerCPU, current_thread ) >();
+  }
+
+  inline Process* PerCPU::process() {
+    return read< Process*, __builtin_offsetof( PerCPU, current_process ) >();
+  }
+
+  inline uint32 PerCPU::id() {
+    return read< uint32, __builtin_offsetof( PerCPU, cpu_id ) >();
+  }
+
+  inline void PerCPU::enter( Thread* t, Process* p ) {
+    write< Thread*, __builtin_offsetof( PerCPU, current_thread ) >( t );
+    write< Process*, __builtin_offsetof( PerCPU, current_process ) >( p );
+  }
+
+}
+
+#endif /* KERNEL_PERCPU_HPP_ */
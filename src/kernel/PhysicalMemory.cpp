@@ -71,8 +71,9 @@ namespace kernel {
     }
 
     uint32 size = blks * PAGE_SIZE;
+    lib::sync::MCSLock::Node me;
 
-    mutex.enter();
+    lock.enter( me );
 
     Area* node = sizes.find( size );
 
@@ -80,10 +81,12 @@ namespace kernel {
       node = sizes.nearest( size );
     }
     else {
+      lock.leave( me );
       lib::Exception::throwing( "PhysicalMemory - no memory block of appropriate size!" );
     }
 
     if ( node->key < PAGE_SIZE ) {
+      lock.leave( me );
       lib::Exception::throwing( "PhysicalMemory - picked too small memory area!" );
     }
 
@@ -115,7 +118,7 @@ namespace kernel {
 
     memused += tmp;
 
-    mutex.leave();
+    lock.leave( me );
 
     lib::memset( ( void* ) ptr, 0, tmp );
 
@@ -127,9 +130,14 @@ namespace kernel {
       lib::Exception::throwing( "PhysicalMemory - can not free null!" );
     }
 
+    lib::sync::MCSLock::Node me;
+
+    lock.enter( me );
+
     Area* node = addresses.find( ( uint32 ) v );
 
     if ( node == 0 ) {
+      lock.leave( me );
       lib::Exception::throwing( "PhysicalMemory - freeing unknown memory area!" );
     }
 
@@ -144,6 +152,8 @@ namespace kernel {
     clear( node );
 
     sizes.put( node );
+
+    lock.leave( me );
   }
 
   PhysicalMemory::~PhysicalMemory() {
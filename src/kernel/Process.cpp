@@ -7,10 +7,19 @@
 
 #include "Process.hpp"
 #include <kernel/System.hpp>
+#include <kernel/Futex.hpp>
+#include <lib/std.hpp>
 
 namespace kernel {
 
   Process::Process() {
+    lib::memset( &usage, 0, sizeof(Usage) );
+    living = 0;
+
+    // the system process is built over memory which is not zeroed, its threads check these
+    usermode = false;
+    virtual_memory.page_flags = VirtualMemory::Present | VirtualMemory::Writable;
+
     // our system is a process, too.
     // but does not use standard process setup :)
     if ( system ) {
@@ -37,19 +46,62 @@ namespace kernel {
       }
       virtual_memory.map( ( uint32 ) system, ( uint32 ) system );
 
+      // read only, even for ring 3
+      virtual_memory.map( ( uint32 ) system->shared, lib::SharedPage::Address, VirtualMemory::Present | VirtualMemory::User );
+
+      system->processes_lock.enter();
       system->processes.pushBack( this );
+      system->processes_lock.leave();
     }
   }
 
+  uint64 Process::size() {
+    return sizeof(Usage);
+  }
+
+  uint32 Process::read( void* data, uint32 length ) {
+    bool irq = lib::cli();
+    Usage u = usage;
+    Threads::Iterator* i = threads.iterator();
+
+    while ( *i ) {
+      u.add( ( **i )->usage );
+      ++( *i );
+    }
+    delete i;
+
+    if ( irq )
+      lib::sti();
+
+    if ( length > sizeof(Usage) )
+      length = sizeof(Usage);
+
+    lib::memcpy( data, &u, length );
+
+    return length;
+  }
+
   Process::~Process() {
+    // the reaper must not remove a thread while we walk the list
+    bool irq = lib::cli();
     Threads::Iterator* i = threads.iterator();
 
     while ( *i ) {
       ( **i )->kill();
+      ++( *i );
     }
     delete i;
 
+    if ( irq )
+      lib::sti();
+
+    for ( uint32 n = living; n; n = living ) {
+      Futex::wait( &living, n );
+    }
+
+    system->processes_lock.enter();
     system->processes.remove( this );
+    system->processes_lock.leave();
   }
 
 }
@@ -9,6 +9,7 @@
 #define PROCESS_HPP_
 
 #include <kernel/Thread.hpp>
+#include <kernel/Usage.hpp>
 #include <kernel/VirtualMemory.hpp>
 #include <lib/File.hpp>
 #include <lib/String.hpp>
@@ -22,6 +23,9 @@ namespace kernel {
   /**
    * A Process in the Platin kernel.
    *
+   * Reading a process as a lib::File returns the summed Usage of its
+   * living and dead threads.
+   *
    * @since 08.02.2011
    * @date 24.07.2011
    * @author Arne Simon => email::[arne_simon@gmx.de]
@@ -39,6 +43,9 @@ namespace kernel {
       Threads threads;
       User* user; ///< The user which owns this process.
       State state; ///< The state in which the process is.
+      bool usermode; ///< The threads of the process run in ring 3.
+      Usage usage; ///< The cpu usage of the threads which are already dead.
+      volatile uint32 living; ///< The threads not yet reaped, the futex word of the destructor.
 
       /**
        * Creates a new process.
@@ -47,6 +54,26 @@ namespace kernel {
        */
       Process();
 
+      //--- File functions ---
+
+      /**
+       * @return The size of the Usage record.
+       */
+      uint64 size();
+
+      /**
+       * Copies the Usage record of the process.
+       *
+       * @return The copied bytes.
+       */
+      uint32 read( void* data, uint32 length );
+
+      /**
+       * Kills the threads of the process and waits until the Reaper freed
+       * them, they use the process up to then.
+       *
+       * @attention Must not be called by a thread of the process itself.
+       */
       virtual ~Process();
   };
 
@@ -0,0 +1,124 @@
+/**
+ * Reaper.cpp
+ *
+ * @since 19.10.2026
+ * @author Arne Simon => email::[arne_simon@gmx.de]
+ */
+
+#include "Reaper.hpp"
+#include <kernel/Futex.hpp>
+#include <kernel/PerCPU.hpp>
+#include <kernel/Thread.hpp>
+#include <lib/sync/Atomic.hpp>
+#include <lib/std.hpp>
+
+namespace kernel {
+
+  Thread* volatile Reaper::zombies = 0;
+  volatile uint32 Reaper::buried = 0;
+  uint32 Reaper::reaped = 0;
+  uint32 Reaper::recycled = 0;
+
+  void Reaper::bury( Thread* t ) {
+    Thread* head;
+
+    do {
+      head = zombies;
+      t->zombie_next = head;
+    } while ( lib::sync::compare_exchange( ( volatile uint32* ) &zombies, ( uint32 ) head, ( uint32 ) t )
+        != ( uint32 ) head );
+
+    lib::sync::fetch_add( &buried, 1 );
+    Futex::wake( &buried, 1 );
+  }
+
+  void* Reaper::execute() {
+    while ( true ) {
+      uint32 seen = buried;
+
+      // take the whole list at once, new zombies start a new one
+      Thread* t = ( Thread* ) lib::sync::exchange( ( volatile uint32* ) &zombies, 0 );
+
+      if ( t == 0 ) {
+        Futex::wait( &buried, seen );
+        continue;
+      }
+
+      while ( t ) {
+        Thread* n = t->zombie_next;
+
+        delete t;
+        reaped++;
+
+        t = n;
+      }
+    }
+
+    return 0;
+  }
+
+  void* Reaper::takeThread() {
+    void* t = 0;
+    bool irq = lib::cli();
+    PerCPU* c = PerCPU::local();
+
+    if ( c->thread_count ) {
+      t = c->threads[ --c->thread_count ];
+      recycled++;
+    }
+
+    if ( irq )
+      lib::sti();
+
+    return t;
+  }
+
+  bool Reaper::keepThread( void* t ) {
+    bool kept = false;
+    bool irq = lib::cli();
+    PerCPU* c = PerCPU::local();
+
+    if ( c->thread_count < PerCPU::CacheSize ) {
+      c->threads[ c->thread_count++ ] = t;
+      kept = true;
+    }
+
+    if ( irq )
+      lib::sti();
+
+    return kept;
+  }
+
+  uint8* Reaper::takeStack() {
+    uint8* s = 0;
+    bool irq = lib::cli();
+    PerCPU* c = PerCPU::local();
+
+    if ( c->stack_count ) {
+      s = c->stacks[ --c->stack_count ];
+      recycled++;
+    }
+
+    if ( irq )
+      lib::sti();
+
+    return s;
+  }
+
+  bool Reaper::keepStack( uint8* stack ) {
+    bool kept = false;
+    bool irq = lib::cli();
+    PerCPU* c = PerCPU::local();
+
+    if ( c->stack_count < PerCPU::CacheSize ) {
+      c->stacks[ c->stack_count++ ] = stack;
+      kept = true;
+    }
+
+    if ( irq )
+      lib::sti();
+
+    return kept;
+  }
+
+}
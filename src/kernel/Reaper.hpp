@@ -0,0 +1,81 @@
+/**
+ * Reaper.hpp
+ *
+ * @since 19.10.2026
+ * @author Arne Simon => email::[arne_simon@gmx.de]
+ */
+
+#ifndef KERNEL_REAPER_HPP_
+#define KERNEL_REAPER_HPP_
+
+#include <cpp.hpp>
+
+namespace kernel {
+
+  class Thread;
+
+  /**
+   * Reclaims dead threads outside of the dispatcher.
+   *
+   * A killed thread is only pushed on the lock free zombie list, the timer
+   * interrupt skips it from then on. The reaper is a kernel thread of the
+   * idle class, which frees the zombies in a batch. Thread objects and
+   * default sized kernel stacks are not given back to the allocator, but
+   * kept in the small caches of the PerCPU area for the next threads, so
+   * the caches need no lock, only the interrupts off.
+   *
+   * @since 19.10.2026
+   * @author Arne Simon => email::[arne_simon@gmx.de]
+   */
+  class Reaper {
+    protected:
+      static Thread* volatile zombies; ///< Dead threads, linked by Thread::zombie_next.
+      static volatile uint32 buried; ///< Counts the buried threads, the futex word of the reaper.
+
+
+    public:
+      static const uint8 Priority = 0; ///< Thread::IdlePriority, the reaper only runs if no normal thread is ready.
+
+      static uint32 reaped; ///< The number of reclaimed threads.
+      static uint32 recycled; ///< The number of thread objects and stacks served from the caches.
+
+      /**
+       * Hands a dead thread over to the reaper.
+       *
+       * @note Lock free, so it is safe in interrupt context.
+       */
+      static void bury( Thread* t );
+
+      /**
+       * The main loop of the reaper thread.
+       */
+      static void* execute();
+
+      /**
+       * @return A cached thread object or null.
+       */
+      static void* takeThread();
+
+      /**
+       * Keeps a thread object for reuse.
+       *
+       * @return False if the cache is full and the memory has to be freed.
+       */
+      static bool keepThread( void* t );
+
+      /**
+       * @return A cached kernel stack of Thread::DefaultStackSize or null.
+       */
+      static uint8* takeStack();
+
+      /**
+       * Keeps a kernel stack of Thread::DefaultStackSize for reuse.
+       *
+       * @return False if the cache is full and the memory has to be freed.
+       */
+      static bool keepStack( uint8* stack );
+  };
+
+}
+
+#endif /* KERNEL_REAPER_HPP_ */
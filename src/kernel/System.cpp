@@ -6,6 +6,10 @@
  */
 
 #include "System.hpp"
+#include <kernel/Reaper.hpp>
+#include <kernel/SystemCall.hpp>
+#include <kernel/Deadline.hpp>
+#include <kernel/Trace.hpp>
 #include <lib/collection/Heap.hpp>
 
 extern "C" void isr0();
@@ -84,26 +88,59 @@ void isr_print_cpu_error( kernel::Thread::State* state ) {
   //system->video << " by thread " << ( **system->next )->id();
 }
 
+/**
+ * The page fault pushes an error code behind the vector, so the frame of
+ * the cpu starts one field later there.
+ *
+ * @return The code segment the interrupt came from.
+ */
+static inline uint32 isr_cs( kernel::Thread::State* state ) {
+  return state->irq == 14 ? state->EFLAGS : state->CS;
+}
+
 kernel::Thread::State* isrcallback( kernel::Thread::State* state ) {
+  kernel::Thread* self = kernel::Thread::current();
+  uint32 irq = state->irq; // state may become the one of another thread
+
+  // the cycles up to here belong to the user code the interrupt hit
+  if ( self && ( isr_cs( state ) & 3 ) )
+    self->account( true );
+
+  kernel::Trace::log( kernel::Trace::IRQEnter, state->irq, self ? self->_id : 0 );
 
   if ( state->irq < 0x20 ) {
-    if ( state->irq == 14 ) { // page exception
+    if ( state->irq == 7 ) { // device not available, lazy fpu switch
+      system->switchFPU( state );
+    }
+    else if ( state->irq == 14 ) { // page exception
       uint32 virtual_addr, page;
 
       asm volatile("mov %%cr2, %0": "=b"(virtual_addr));
 
-      page = ( uint32 ) kernel::System::physical_memory.alloc();
-      system->virtual_memory.map( page, virtual_addr );
+      if ( isr_cs( state ) & 3 ) {
+        // a process only touches what it mapped, it does not get pages of the kernel
+        kernel::System::disablePaging();
 
+        system->video.color( kernel::Video::LightRed );
+        system->video << "thread-" << self->id() << " page fault, wanted addr " << virtual_addr << "\n";
+        system->video.color( kernel::Video::LightGrey );
+
+        self->kill();
+
+        state = system->dispatch()->state; // execute another thread
+      }
+      else {
+        page = ( uint32 ) kernel::System::physical_memory.alloc();
+        system->virtual_memory.map( page, virtual_addr );
+      }
     }
     else {
       isr_print_cpu_error( state );
       asm volatile("cli;hlt;");
     }
   }
-  else if ( state->irq < 0x40 ) { // hardware and software interrupts
+  else if ( state->irq < 0x64 ) { // hardware and software interrupts
     //kernel::System::disablePaging();
-    uint32 irq = state->irq;
     uint32 cr0;
     asm volatile("mov %%cr0, %0": "=b"(cr0));
     cr0 &= ~0x80000000;
@@ -119,9 +156,10 @@ kernel::Thread::State* isrcallback( kernel::Thread::State* state ) {
 
         state = t->state;
       break;
+      default: // device interrupts, only the top halves run here
+        system->interrupt( irq );
+      break;
       case 0x30: // exception
-        t->mode = kernel::Thread::DEAD;
-
         lib::Exception* e = ( lib::Exception* ) state->ESP;
 
         system->video.color( kernel::Video::LightRed );
@@ -131,7 +169,7 @@ kernel::Thread::State* isrcallback( kernel::Thread::State* state ) {
         asm volatile("cli;hlt;");
 
         delete e; // delete exception
-        delete t; // kill the thread which makes trouble.
+        t->kill(); // kill the thread which makes trouble.
 
         system->schedule();
         state = system->dispatch()->state; // execute another thread
@@ -145,13 +183,44 @@ kernel::Thread::State* isrcallback( kernel::Thread::State* state ) {
       kernel::System::enablePaging();
     }
   }
-  else if ( state->irq <= 99 ) {
-    //system->interrupts.push( ( uint8 ) state->irq ); // tell the core which interrupt was invoked.
+  else if ( state->irq == lib::Syscall::Vector ) { // system call, the slow path
+    uint32 cr0;
+    asm volatile("mov %%cr0, %0": "=r"(cr0));
+    cr0 &= ~0x80000000;
+    asm volatile("mov %0, %%cr0":: "r"(cr0));
+
+    kernel::SystemCall::Frame frame;
+
+    frame.EAX = state->EAX;
+    frame.EBX = state->EBX;
+    frame.ESI = state->ESI;
+    frame.EDI = state->EDI;
+
+    // a system call may block, so it runs with interrupts like SYSENTER
+    lib::sti();
+    kernel::SystemCall::call( &frame );
+    lib::cli();
+
+    state->EAX = frame.EAX;
+
+    self->account( false );
+
+    kernel::Trace::log( kernel::Trace::IRQExit, lib::Syscall::Vector, self->_id );
+
+    return state; // the wrapper restores the paging from the state, no eoi
   }
 
 // acknowledge that the interrupt was handled,
-// so we can receive another one!
-  kernel::System::eoi( state->irq );
+// so we can receive another one! Only the lines of the PIC want it.
+  if ( irq >= kernel::System::PIC_Master_Offset && irq < kernel::System::PIC_Slave_Offset + 8u )
+    kernel::System::eoi( irq );
+
+  self = kernel::Thread::current();
+
+  if ( self && ( isr_cs( state ) & 3 ) )
+    self->account( false );
+
+  kernel::Trace::log( kernel::Trace::IRQExit, irq, self ? self->_id : 0 );
 
   return state; // return thread state
 }
@@ -187,6 +256,9 @@ namespace kernel {
       set_isr( i, addr );
       addr += step;
     }
+
+    // ring 3 may raise the system call gate
+    idt_table[ lib::Syscall::Vector ] |= ( uint64 ) GDT_RING3 << 40;
   }
 
   void System::set_isr( uint8 IRQ, uint32 F ) {
@@ -202,6 +274,7 @@ namespace kernel {
 
     tss.IOPB = sizeof(TSS) << 16;
     //tss.IOPB = 0;
+    tss.SS0 = KernelData; // the stack for interrupts from ring 3, ESP0 is set by the dispatcher
 
     // Selector 0x00 cannot be used
     set_gdt( 0, 0, 0, 0 );
@@ -214,14 +287,27 @@ namespace kernel {
     // We will use all memory as our data segment!
     set_gdt( 2, 0, 0xFFFFFFFF, GDT_DATASEG | GDT_GRAN_4K | GDT_PRESENT | GDT_SEGMENT | GDT_BIT32 );
 
-    // Selector 0x18 will be our tss.
+    // Selector 0x18 will be the code of user processes.
+    set_gdt( 3, 0, 0xFFFFFFFF, GDT_CODESEG | GDT_GRAN_4K | GDT_PRESENT | GDT_SEGMENT | GDT_BIT32 | GDT_RING3 );
+
+    // Selector 0x20 will be the data of user processes.
+    set_gdt( 4, 0, 0xFFFFFFFF, GDT_DATASEG | GDT_GRAN_4K | GDT_PRESENT | GDT_SEGMENT | GDT_BIT32 | GDT_RING3 );
+
+    // Selector 0x28 will be our tss.
     // Set our kernel TSS.
-    set_gdt( 3, ( uint32 ) &tss, sizeof(TSS), GDT_TSS | GDT_PRESENT | GDT_BIT32 );
+    set_gdt( 5, ( uint32 ) &tss, sizeof(TSS), GDT_TSS | GDT_PRESENT | GDT_BIT32 );
+
+    // Selector 0x30 is never loaded, its limit is the number of the cpu for lsl in ring 3.
+    set_gdt( 6, 0, 0, GDT_DATASEG | GDT_PRESENT | GDT_SEGMENT | GDT_RING3 );
+
+    // Selector 0x38 will be the PerCPU area of the boot cpu, loaded in GS.
+    PerCPU::setup( 0 );
+    set_gdt( 7, ( uint32 ) &PerCPU::areas[ 0 ], sizeof(PerCPU) - 1, GDT_DATASEG | GDT_PRESENT | GDT_SEGMENT | GDT_BIT32 );
 
     asm volatile(
         //       "cli;"
         "lgdt %0;"
-        "mov $0x18, %%eax;"
+        "mov $0x28, %%eax;"
         "ltr %%ax;"
         //       "sti;"
         : : "m" (gdt_address));
@@ -231,8 +317,9 @@ namespace kernel {
         "mov   %ax, %ds;"
         "mov   %ax, %es;"
         "mov   %ax, %fs;"
-        "mov   %ax, %gs;"
         "mov   %ax, %ss;"
+        "mov   $0x38, %ax;"
+        "mov   %ax, %gs;"
         "ljmp $0x8, $.1;"
         ".1:;"
     );
@@ -240,7 +327,7 @@ namespace kernel {
   }
 
   void System::eoi( int IRQ ) {
-    if ( IRQ > 7 )
+    if ( IRQ >= PIC_Slave_Offset )
       lib::outb( PIC_SlaveCmd, PIC_EOI ); // tell slave PIC that the interrupt is acknowledged.
 
     lib::outb( PIC_MasterCmd, PIC_EOI ); // tell master PIC that the interrupt is acknowledged.
@@ -257,21 +344,75 @@ namespace kernel {
     lib::outb( PIC_MasterData, PIC_ICW4_8086 );
     lib::outb( PIC_SlaveData, PIC_ICW4_8086 );
 
-    // restore masks.
-    lib::outb( PIC_MasterData, 0xfc );
+    // only the timer, the other lines are unmasked by attach()
+    lib::outb( PIC_MasterData, 0xfe );
     lib::outb( PIC_SlaveData, 0xff );
   }
 
+  void System::setup_fpu() {
+    uint32 a[ 4 ];
+    uint32 cr0, cr4;
+
+    lib::cpuid( 0x01, a );
+
+    asm volatile("mov %%cr0, %0": "=r"(cr0));
+    cr0 &= ~( CR0_EM | CR0_TS );
+    cr0 |= CR0_MP | CR0_NE;
+    asm volatile("mov %0, %%cr0":: "r"(cr0));
+
+    fxsr = a[ 3 ] & ( 1 << 24 );
+
+    if ( fxsr ) {
+      asm volatile("mov %%cr4, %0": "=r"(cr4));
+      cr4 |= CR4_OSFXSR;
+
+      if ( a[ 3 ] & ( 1 << 25 ) ) // sse
+        cr4 |= CR4_OSXMMEXCPT;
+
+      asm volatile("mov %0, %%cr4":: "r"(cr4));
+    }
+
+    asm volatile("fninit");
+  }
+
+  void System::switchFPU( Thread::State* state ) {
+    Thread* t = Thread::current();
+
+    asm volatile("clts");
+
+    if ( fpu_owner != t ) {
+      if ( fpu_owner )
+        fpu_owner->saveFPU();
+
+      if ( t )
+        t->restoreFPU();
+
+      fpu_owner = t;
+    }
+
+    state->cr0 &= ~CR0_TS; // the wrapper reloads cr0 from the state
+  }
+
+  /**
+   * @return True for threads of the time sharing class which may run.
+   */
+  static inline bool runnable( Thread* t ) {
+    return ( t->mode == Thread::READY || t->mode == Thread::START ) && t->realtime.runtime == 0;
+  }
+
   bool HeapThreadCompare( Thread*& a, Thread*& b ) {
-    return a->behavior.priority <= b->behavior.priority;
+    return a->priority() <= b->priority();
   }
 
   PhysicalMemory System::physical_memory;
+  bool System::fxsr = false;
 
   void* System::operator new( uint32 size, MultiBoot* multiboot ) {
     setup_gdt();
     setup_idt();
     setup_pic();
+    setup_fpu();
+    SystemCall::setup();
 
     physical_memory.analyse( multiboot );
 
@@ -307,10 +448,19 @@ namespace kernel {
 
     user = new User( "system" );
 
+    users_lock.writeEnter();
+    users.push( user );
+    users_lock.writeLeave();
+
     // we deactivate the timer
     timer.init( PIT::Mod_TerminalCount );
     timer.load( 0xffff );
 
+    shared = ( lib::SharedPage* ) physical_memory.alloc();
+    lib::memset( shared, 0, PhysicalMemory::PAGE_SIZE );
+    shared->cpus = MaxCPUs;
+    shared->calibrate( PIT::calibrate() );
+
     _id = ProcessIDPool++;
 
     Thread* k = ( Thread* ) virtual_memory.alloc( sizeof(Thread) ); // this thread represents our kernel thread
@@ -323,10 +473,18 @@ namespace kernel {
 
     k->mode = Thread::RUNNING; // our kernel is already running :)
 
+    // after booting it only halts the cpu
+    k->behavior.priority = Thread::IdlePriority;
+    k->behavior.inherited = 0;
+
     k->_process = this;
 
     threads.pushBack( k );
 
+    fpu_owner = k; // the kernel may already have used the fpu
+
+    k->stamp = lib::rdtsc();
+
     schedule();
 
     state = Process::Active;
@@ -337,6 +495,17 @@ namespace kernel {
 
     next = plan->iterator();
 
+    PerCPU::enter( k, this );
+
+    lib::memset( vectors, 0, sizeof(vectors) );
+
+    Thread* reaper = new Thread( this, ( uint32 ) &Reaper::execute, Thread::DefaultStackSize );
+    reaper->behavior.priority = Reaper::Priority;
+
+    interrupthandler = new InterruptHandler();
+    ahci = 0;
+    virtio = 0;
+
     video.clear();
   }
 
@@ -353,26 +522,193 @@ namespace kernel {
 
     Thread* c = **next;
 
+    c->account( false );
+
+    Thread::alarm( c->stamp );
+
     // if our current thread is not blocked,
     // set it ready!
     if ( c->mode != Thread::BLOCKED && c->mode != Thread::DEAD )
       c->mode = Thread::READY;
 
-    // look for the next thread which is ready or started.
+    // look for the next thread which is ready or started,
+    // dead threads are left to the reaper.
+    // Without any, a ready deadline thread goes on, even if it is throttled.
     do {
-      if ( ( **next )->mode == Thread::DEAD ) // delete dead threads
-        delete ( **next );
-
       ++( *next );
-    } while ( ( **next )->mode != Thread::READY && ( **next )->mode != Thread::START );
+    } while ( not runnable( **next ) && not ( **next == c && c->mode == Thread::READY ) );
+
+    // a thread with a higher priority goes first, equal ones take turns,
+    // a thread stepping aside only goes on if no other one is ready
+    SchedulingPlan::Iterator i = *next;
+    bool aside = c->aside && **next == c;
+
+    for ( uint32 n = plan->size(); n > 1; --n ) {
+      ++i;
+
+      Thread* t = *i;
+
+      if ( t == c && c->aside )
+        continue;
+
+      if ( runnable( t ) && ( aside || t->priority() > ( **next )->priority() ) ) {
+        *next = i;
+        aside = false;
+      }
+    }
+
+    // the deadline class goes before the time sharing class
+    Thread* rt = Deadline::pick( c, c->stamp );
+
+    if ( rt ) {
+      while ( **next != rt ) {
+        ++( *next );
+      }
+    }
+
+    Deadline::arm( **next, c->stamp );
 
     // set the current state to running
     ( **next )->mode = Thread::RUNNING;
 
+    if ( **next != c ) {
+      Thread* n = **next;
+
+      if ( c->mode != Thread::READY || c->yielded )
+        c->usage.voluntary++;
+      else
+        c->usage.involuntary++;
+
+      n->usage.ready += c->stamp - n->stamp;
+      n->stamp = c->stamp;
+
+      Trace::log( Trace::Dispatch, c->_id, n->_id );
+    }
+
+    c->yielded = false;
+    c->aside = false;
+
+    shared->update();
+
+    PerCPU::enter( **next, ( **next )->process() );
+
+    // interrupts and system calls from ring 3 start on the kernel stack of the thread
+    if ( ( **next )->ring0_stack ) {
+      tss.ESP0 = ( uint32 ) ( **next )->ring0_stack + Thread::Ring0StackSize;
+      SystemCall::stack( tss.ESP0 );
+    }
+
+    // only the owner of the fpu registers may use them without a trap
+    if ( ( **next ) == fpu_owner )
+      ( **next )->state->cr0 &= ~CR0_TS;
+    else
+      ( **next )->state->cr0 |= CR0_TS;
+
     return ( **next );
 
   }
 
+  void System::interrupt( uint32 irq ) {
+    Vector& v = vectors[ irq ];
+    bool claimed = false;
+
+    v.fired++;
+
+    // on a shared line every routine checks its device
+    for ( Vector* b = &v; b; b = b->more ) {
+      for ( uint32 i = 0; i < b->count; ++i ) {
+        if ( b->routines[ i ]->call() )
+          claimed = true;
+      }
+    }
+
+    if ( claimed ) {
+      v.claimed++;
+    }
+    else if ( ++v.unclaimed >= UnclaimedLimit && v.claimed == 0 && irq > PIC_Master_Offset
+        && irq < PIC_Slave_Offset + 8 ) {
+      mask( irq );
+    }
+  }
+
+  void System::attach( uint8 irq, ISR* isr ) {
+    if ( irq >= VectorCount ) {
+      lib::Exception::throwing( "System - attach to an unknown interrupt vector!" );
+    }
+
+    Vector* b = &vectors[ irq ];
+    Vector* extra = 0;
+
+    // allocating with interrupts off is fine, but keep that time short
+    while ( b->more )
+      b = b->more;
+
+    if ( b->count == Vector::Inline )
+      extra = new Vector();
+
+    bool irqs = lib::cli();
+
+    if ( extra ) {
+      b->more = extra;
+      b = extra;
+    }
+
+    b->routines[ b->count++ ] = isr;
+
+    if ( irq > PIC_Master_Offset && irq < PIC_Slave_Offset + 8 )
+      unmask( irq );
+
+    if ( irqs )
+      lib::sti();
+  }
+
+  void System::detach( uint8 irq, ISR* isr ) {
+    if ( irq >= VectorCount )
+      return;
+
+    bool irqs = lib::cli();
+    bool empty = true;
+
+    for ( Vector* b = &vectors[ irq ]; b; b = b->more ) {
+      for ( uint32 i = 0; i < b->count; ++i ) {
+        if ( b->routines[ i ] == isr ) {
+          b->routines[ i ] = b->routines[ --b->count ];
+          --i;
+        }
+      }
+
+      if ( b->count )
+        empty = false;
+    }
+
+    if ( empty && irq > PIC_Master_Offset && irq < PIC_Slave_Offset + 8 )
+      mask( irq );
+
+    if ( irqs )
+      lib::sti();
+  }
+
+  void System::mask( uint8 irq ) {
+    uint8 line = irq - PIC_Master_Offset;
+
+    if ( line < 8 )
+      lib::outb( PIC_MasterData, lib::inb( PIC_MasterData ) | ( 1 << line ) );
+    else
+      lib::outb( PIC_SlaveData, lib::inb( PIC_SlaveData ) | ( 1 << ( line - 8 ) ) );
+  }
+
+  void System::unmask( uint8 irq ) {
+    uint8 line = irq - PIC_Master_Offset;
+
+    if ( line < 8 ) {
+      lib::outb( PIC_MasterData, lib::inb( PIC_MasterData ) & ~( 1 << line ) );
+    }
+    else {
+      lib::outb( PIC_SlaveData, lib::inb( PIC_SlaveData ) & ~( 1 << ( line - 8 ) ) );
+      lib::outb( PIC_MasterData, lib::inb( PIC_MasterData ) & ~( 1 << 2 ) ); // the cascade
+    }
+  }
+
   void System::switchToPageDirectory( uint32* PD ) {
     asm volatile("mov %0, %%cr3":: "r"( PD ) );
   }
@@ -17,12 +17,17 @@
 #include <kernel/Thread.hpp>
 #include <kernel/InterruptHandler.hpp>
 #include <kernel/ISR.hpp>
+#include <kernel/WorkQueue.hpp>
 #include <kernel/TSS.hpp>
+#include <kernel/PerCPU.hpp>
 #include <kernel/User.hpp>
 #include <lib/collection/RingBuffer.hpp>
 #include <lib/collection/Ring.hpp>
 #include <lib/collection/List.hpp>
 #include <lib/collection/Set.hpp>
+#include <lib/sync/Mutex.hpp>
+#include <lib/sync/RWLock.hpp>
+#include <lib/SharedPage.hpp>
 
 /**
  * @attention Before this method, this commands are called
@@ -67,6 +72,11 @@ extern "C" kernel::Thread::State* isrcallback( kernel::Thread::State* state );
 
 namespace kernel {
 
+  namespace driver {
+    class AHCI;
+    class VirtioBlock;
+  }
+
   /**
    * System will setup the following components of the CPU:
    * <ol>
@@ -87,15 +97,59 @@ namespace kernel {
    */
   class System: public Process {
     public:
-      typedef lib::collection::RingBuffer< uint8, 20 > Interrupts;
       typedef lib::collection::Ring< Thread* > SchedulingPlan;
-      typedef lib::collection::List< ISR* > ISRList;
+
+      /**
+       * The interrupt service routines of one vector.
+       *
+       * The first routines are stored inline, further routines of a shared
+       * line are chained in extra blocks, which are allocated by attach(),
+       * so the dispatch path never allocates.
+       */
+      struct Vector {
+          static const uint32 Inline = 4;
+
+          ISR* routines[ Inline ];
+          uint32 count; ///< Used entries in routines.
+          Vector* more; ///< The next block of a shared line, or null.
+
+          uint32 fired; ///< How often the vector was raised.
+          uint32 claimed; ///< How often a routine accepted the interrupt.
+          uint32 unclaimed; ///< How often no routine accepted the interrupt.
+      };
+
+      static const uint32 VectorCount = 100;
+      static const uint32 UnclaimedLimit = 1000; ///< A PIC line nobody claims that often gets masked.
       typedef lib::collection::List< User* > Users;
       typedef lib::collection::List< Process* > Processes;
 
-      static const uint8 EntryCount = 4;
+      static const uint32 MaxCPUs = 1; ///< The kernel only runs on the boot cpu yet.
+      static const uint8 EntryCount = 7 + MaxCPUs; ///< One PerCPU segment per cpu at the end.
+
+      //--- GDT Selectors ---
+      // SYSENTER/SYSEXIT expect kernel code, kernel data, user code and user data in this order.
+
+      static const uint16 KernelCode = 0x08;
+      static const uint16 KernelData = 0x10;
+      static const uint16 UserCode = 0x18 | 3;
+      static const uint16 UserData = 0x20 | 3;
+      static const uint16 TSSSelector = 0x28;
+      static const uint16 CPUSelector = lib::SharedPage::CPUSelector;
+      static const uint16 PerCPUSelector = 0x38; ///< The PerCPU segment of the boot cpu, kept in GS.
       static const uint16 IRQCount = 256;
 
+      //--- CR0 Flags ---
+
+      static const uint32 CR0_MP = 1 << 1; ///< Monitor coprocessor, WAIT honours TS.
+      static const uint32 CR0_EM = 1 << 2; ///< Emulate the FPU.
+      static const uint32 CR0_TS = 1 << 3; ///< Task switched, the next FPU instruction raises #NM.
+      static const uint32 CR0_NE = 1 << 5; ///< Native FPU errors.
+
+      //--- CR4 Flags ---
+
+      static const uint32 CR4_OSFXSR = 1 << 9; ///< FXSAVE/FXRSTOR and SSE are allowed.
+      static const uint32 CR4_OSXMMEXCPT = 1 << 10; ///< Unmasked SSE exceptions raise #XM.
+
       /**
        * The address for the IDT and GDT.
        */
@@ -196,6 +250,22 @@ namespace kernel {
        */
       static void setup_pic();
 
+      /**
+       * Enables the FPU and, if supported, FXSAVE and SSE.
+       *
+       * The FPU registers are switched lazily. The dispatcher sets CR0.TS
+       * for every thread which does not own the FPU registers, so its first
+       * FPU or SSE instruction raises a Device Not Available exception and
+       * switchFPU() moves the registers over. Threads which never touch the
+       * FPU pay nothing.
+       */
+      static void setup_fpu();
+
+      /**
+       * Acknowledges a line of the PIC, the slave one too for its lines.
+       *
+       * @param IRQ The vector of the line, 0x20 to 0x2f.
+       */
       static void eoi( int IRQ );
 
       /**
@@ -229,19 +299,26 @@ namespace kernel {
     public:
       //Memory memory;
       static PhysicalMemory physical_memory; ///< The physical memory handler.
+      static bool fxsr; ///< FXSAVE/FXRSTOR are supported, else FSAVE/FRSTOR is used.
+      Thread* fpu_owner; ///< The thread whose state is in the FPU registers, or null.
       Video video;
       PIT timer;
       InterruptHandler* interrupthandler;
+      driver::AHCI* ahci; ///< The AHCI controller, its ports are the SATA drives to mount from, or null.
+      driver::VirtioBlock* virtio; ///< The virtio block device to mount from, or null.
       uint32 ProcessIDPool; ///< Holds the next usable id for a process.
       uint32 ThreadIDPool; ///< Holds the next usable id for a thread.
-      Interrupts interrupts; ///< Fired interrupts which should be handled by the kernel.
+      WorkQueue work[ MaxCPUs ]; ///< The deferred bottom halves of each cpu.
       Processes processes; ///< A list of processes.
+      lib::sync::Mutex processes_lock; ///< Guards processes while they come and go.
       SchedulingPlan* plan;
+      lib::SharedPage* shared; ///< The clock page, mapped read only into every process.
       SchedulingPlan::Iterator* next;
-      lib::collection::Set<User*> users;
+      lib::collection::Set<User*> users; ///< The known users, only a log in or out changes them.
+      lib::sync::RWLock users_lock; ///< Guards users, looking one up only takes the read lock.
 
       /**
-       * An array of interrupt service routine lists.
+       * The interrupt service routines for each vector.
        *
        * Interrupt list:
        * @code
@@ -289,7 +366,37 @@ namespace kernel {
        * @attention Interrupt 0x30 is the standard exception!
        *
        */
-      ISRList isr[ 100 ];
+      Vector vectors[ VectorCount ];
+
+      /**
+       * Registers an interrupt service routine.
+       *
+       * A PIC line is unmasked with its first routine.
+       *
+       * @param irq The vector, 0x21 to 0x2f for the PIC lines, 0x40 to 0x63 for the rest.
+       */
+      void attach( uint8 irq, ISR* isr );
+
+      /**
+       * Removes an interrupt service routine.
+       *
+       * A PIC line is masked again with its last routine.
+       */
+      void detach( uint8 irq, ISR* isr );
+
+      /**
+       * Masks a line of the PIC.
+       *
+       * @param irq The vector of the line, 0x20 to 0x2f.
+       */
+      static void mask( uint8 irq );
+
+      /**
+       * Unmasks a line of the PIC.
+       *
+       * @param irq The vector of the line, 0x20 to 0x2f.
+       */
+      static void unmask( uint8 irq );
 
       /**
        * Setting up the absolute basic system.
@@ -316,6 +423,43 @@ namespace kernel {
        */
       Thread* dispatch();
 
+      /**
+       * @return The number of the executing cpu.
+       */
+      static uint32 cpu() {
+        return PerCPU::id();
+      }
+
+      /**
+       * Runs the top halves of the routines registered for a device interrupt.
+       *
+       * A PIC line which fired UnclaimedLimit times without any routine
+       * accepting it, and was never claimed before, gets masked.
+       */
+      void interrupt( uint32 irq );
+
+      /**
+       * Defers the bottom half of an interrupt service routine to the
+       * InterruptHandler of the executing cpu.
+       *
+       * @note Lock free, meant to be called by ISR::call().
+       *
+       * @param isr The routine whose ISR::work() is called.
+       * @param data The parameter for ISR::work().
+       * @return False if the queue was full and the work got dropped.
+       */
+      bool defer( ISR* isr, uint32 data, WorkQueue::Priority priority = WorkQueue::Normal ) {
+        return work[ cpu() ].push( isr, data, priority );
+      }
+
+      /**
+       * Handles the Device Not Available exception.
+       *
+       * Saves the FPU registers for their owner and loads them for the
+       * current thread, then clears CR0.TS in the state the thread returns to.
+       */
+      void switchFPU( Thread::State* state );
+
       /**
        *
        * @param fromP
@@ -0,0 +1,131 @@
+/**
+ * SystemCall.cpp
+ *
+ * @since 19.10.2026
+ * @author Arne Simon => email::[arne_simon@gmx.de]
+ */
+
+#include "SystemCall.hpp"
+#include <kernel/System.hpp>
+#include <kernel/Futex.hpp>
+
+extern "C" void sysenter_entry();
+
+/**
+ * Called by sysenter_entry in isr.asm.
+ */
+extern "C" void syscallback( kernel::SystemCall::Frame* frame ) {
+  kernel::Thread* self = kernel::Thread::current();
+
+  self->account( true );
+  kernel::SystemCall::call( frame );
+  self->account( false );
+}
+
+namespace kernel {
+
+  SystemCall::Handler SystemCall::table[ lib::Syscall::Count ];
+  bool SystemCall::fast = false;
+
+  void SystemCall::setup() {
+    table[ lib::Syscall::Nop ] = &SystemCall::nop;
+    table[ lib::Syscall::Exit ] = &SystemCall::exit;
+    table[ lib::Syscall::Yield ] = &SystemCall::yield;
+    table[ lib::Syscall::Write ] = &SystemCall::write;
+    table[ lib::Syscall::FutexWait ] = &SystemCall::futexWait;
+    table[ lib::Syscall::FutexWake ] = &SystemCall::futexWake;
+    table[ lib::Syscall::ThreadId ] = &SystemCall::threadId;
+
+    if ( lib::Syscall::available() ) {
+      lib::set_msr( SYSENTER_CS, System::KernelCode, 0 );
+      lib::set_msr( SYSENTER_EIP, ( uint32 ) &sysenter_entry, 0 );
+      fast = true;
+    }
+  }
+
+  void SystemCall::call( Frame* frame ) {
+    if ( frame->EAX < lib::Syscall::Count )
+      frame->EAX = table[ frame->EAX ]( frame );
+    else
+      frame->EAX = Error;
+  }
+
+  uint8* SystemCall::user( uint32 address ) {
+    VirtualMemory& vm = Thread::current()->process()->virtual_memory;
+
+    if ( vm.page_directoies == 0 )
+      return ( uint8* ) address; // a kernel thread
+
+    uint32 pde = vm.page_directoies[ address >> 22 ];
+
+    if ( ( pde & VirtualMemory::Present ) == 0 )
+      return 0;
+
+    uint32 pte = ( ( uint32* ) ( pde & 0xFFFFF000 ) )[ ( address >> 12 ) & 0x03FF ];
+
+    if ( ( pte & ( VirtualMemory::Present | VirtualMemory::User ) ) != ( VirtualMemory::Present | VirtualMemory::User ) )
+      return 0;
+
+    return ( uint8* ) ( ( pte & 0xFFFFF000 ) | ( address & 0xFFF ) );
+  }
+
+  uint32 SystemCall::nop( Frame* ) {
+    return 0;
+  }
+
+  uint32 SystemCall::exit( Frame* frame ) {
+    Thread::exit( ( void* ) frame->EBX );
+    return 0;
+  }
+
+  uint32 SystemCall::yield( Frame* ) {
+    Thread::yield();
+    return 0;
+  }
+
+  uint32 SystemCall::write( Frame* frame ) {
+    uint32 address = frame->EBX;
+    uint32 length = frame->ESI;
+
+    for ( uint32 i = 0; i < length; ) {
+      uint8* p = user( address + i );
+
+      if ( p == 0 )
+        return Error;
+
+      // up to the end of the page
+      uint32 n = PhysicalMemory::PAGE_SIZE - ( ( address + i ) & 0xFFF );
+
+      if ( n > length - i )
+        n = length - i;
+
+      system->video.write( ( void* ) p, n );
+      i += n;
+    }
+
+    return length;
+  }
+
+  uint32 SystemCall::futexWait( Frame* frame ) {
+    volatile uint32* word = ( volatile uint32* ) user( frame->EBX );
+
+    if ( word == 0 || ( frame->EBX & 3 ) )
+      return Error;
+
+    return Futex::wait( word, frame->ESI );
+  }
+
+  uint32 SystemCall::futexWake( Frame* frame ) {
+    volatile uint32* word = ( volatile uint32* ) user( frame->EBX );
+
+    if ( word == 0 || ( frame->EBX & 3 ) )
+      return Error;
+
+    return Futex::wake( word, frame->ESI );
+  }
+
+  uint32 SystemCall::threadId( Frame* ) {
+    return Thread::current()->id();
+  }
+
+}
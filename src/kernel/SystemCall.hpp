@@ -0,0 +1,102 @@
+/**
+ * SystemCall.hpp
+ *
+ * @since 19.10.2026
+ * @author Arne Simon => email::[arne_simon@gmx.de]
+ */
+
+#ifndef KERNEL_SYSTEMCALL_HPP_
+#define KERNEL_SYSTEMCALL_HPP_
+
+#include <cpp.hpp>
+#include <lib/Syscall.hpp>
+
+namespace kernel {
+
+  /**
+   * The kernel side of the system calls, see lib::Syscall for the ABI.
+   *
+   * SYSENTER jumps to sysenter_entry in isr.asm with the kernel stack of the
+   * current thread, which the dispatcher writes into the SYSENTER_ESP msr.
+   * The slow path is the interrupt gate lib::Syscall::Vector, which ring 3
+   * may use. Both end in call(), which runs the handler from the table.
+   *
+   * The kernel runs with paging disabled, so user pointers are translated
+   * with the page tables of the calling process.
+   *
+   * @since 19.10.2026
+   * @author Arne Simon => email::[arne_simon@gmx.de]
+   */
+  class SystemCall {
+    public:
+      /**
+       * The registers of the caller.
+       *
+       * @attention The order is the reversed push order of sysenter_entry.
+       */
+      struct Frame {
+          uint32 EAX; ///< The number of the call, the result on return.
+          uint32 EBX;
+          uint32 ESI;
+          uint32 EDI;
+          uint32 EIP; ///< The return address of SYSEXIT, passed in edx.
+          uint32 ESP; ///< The user stack of SYSEXIT, passed in ecx.
+      };
+
+      typedef uint32 (*Handler)( Frame* frame );
+
+      static const uint32 SYSENTER_CS = 0x174;
+      static const uint32 SYSENTER_ESP = 0x175;
+      static const uint32 SYSENTER_EIP = 0x176;
+
+      static const uint32 Error = 0xffffffff; ///< The result of an unknown call or a bad pointer.
+
+    protected:
+      static Handler table[ lib::Syscall::Count ];
+
+      /**
+       * Translates a pointer of the calling process.
+       *
+       * @return The physical address or null, if the page is not accessible from ring 3.
+       */
+      static uint8* user( uint32 address );
+
+      static uint32 nop( Frame* frame );
+
+      static uint32 exit( Frame* frame );
+
+      static uint32 yield( Frame* frame );
+
+      static uint32 write( Frame* frame );
+
+      static uint32 futexWait( Frame* frame );
+
+      static uint32 futexWake( Frame* frame );
+
+      static uint32 threadId( Frame* frame );
+
+    public:
+      static bool fast; ///< SYSENTER is set up.
+
+      /**
+       * Fills the table and sets up the SYSENTER msrs, if the cpu has them.
+       */
+      static void setup();
+
+      /**
+       * Sets the kernel stack for the next SYSENTER, called by the dispatcher.
+       */
+      static void stack( uint32 esp ) {
+        if ( fast )
+          lib::set_msr( SYSENTER_ESP, esp, 0 );
+      }
+
+      /**
+       * Runs a system call.
+       */
+      static void call( Frame* frame );
+  };
+
+}
+
+#endif /* KERNEL_SYSTEMCALL_HPP_ */
@@ -8,14 +8,57 @@
 #include "Thread.hpp"
 #include <lib/std.hpp>
 #include <kernel/System.hpp>
+#include <kernel/Futex.hpp>
+#include <kernel/Reaper.hpp>
+#include <kernel/Trace.hpp>
+#include <lib/sync/Atomic.hpp>
+
+/**
+ * A kernel thread starts by an iret, which leaves State::ESP and State::para
+ * on the stack. For the thread function they are the return address and the
+ * parameter, so a returning thread function jumps here with its result in eax.
+ */
+extern "C" void thread_return();
+
+extern "C" void thread_exit( void* result ) {
+  kernel::Thread::exit( result );
+}
+
+asm(
+    ".global thread_return;"
+    "thread_return:;"
+    "pushl %eax;"
+    "call thread_exit;"
+);
 
 namespace kernel {
 
+  lib::sync::TicketLock Thread::join_lock;
+  Thread* Thread::sleepers = 0;
+  lib::sync::TicketLock Thread::sleep_lock;
+
   void Thread::init() {
 
     mode = START;
+    mutex = 0;
+    blocked_on = 0;
+    wait_next = 0;
+    futex_key = 0;
+    zombie_next = 0;
+    joiners = 0;
+    sleep_next = 0;
+    wake_at = 0;
+    fpu = 0;
+    ring0_stack = 0;
+
+    lib::memset( &usage, 0, sizeof(Usage) );
+    stamp = lib::rdtsc();
+    yielded = false;
+    aside = false;
+    lib::memset( &realtime, 0, sizeof(Deadline::Reservation) );
 
-    behavior.priority = 0;
+    behavior.priority = NormalPriority;
+    behavior.inherited = 0;
     behavior.duration = 1;
     behavior.step = 0;
 
@@ -23,16 +66,36 @@ namespace kernel {
 
     if ( stack_size ) {
 
-      uint8* virtualstack = ( uint8* ) _process->virtual_memory.alloc( stack_size );
+      uint8* virtualstack = 0;
 
-      if ( _process->virtual_memory.page_directoies ) {
-        stack = ( uint8* ) _process->virtual_memory.getPhysicalAddress( ( uint32 ) virtualstack );
+      if ( stack_size == DefaultStackSize && _process->virtual_memory.page_directoies == 0 )
+        virtualstack = Reaper::takeStack();
+
+      if ( virtualstack == 0 )
+        virtualstack = ( uint8* ) _process->virtual_memory.alloc( stack_size );
+
+      stack = virtualstack;
+
+      if ( _process->usermode ) {
+        // interrupts and system calls from ring 3 switch to this stack,
+        // it is blended into the process at its kernel address.
+        ring0_stack = ( uint8* ) system->virtual_memory.alloc( Ring0StackSize );
+
+        for ( uint32 p = ( uint32 ) ring0_stack & 0xFFFFF000; p < ( uint32 ) ring0_stack + Ring0StackSize; p +=
+            PhysicalMemory::PAGE_SIZE ) {
+          _process->virtual_memory.map( p, p );
+        }
+
+        state = ( State* ) ( ring0_stack + Ring0StackSize - sizeof(State) );
+      }
+      else if ( _process->virtual_memory.page_directoies ) {
+        uint8* physical = ( uint8* ) _process->virtual_memory.getPhysicalAddress( ( uint32 ) virtualstack );
 
         // blend the thread stack into the virtual memory of the process.
-        _process->virtual_memory.map( ( uint32 ) stack, ( uint32 ) virtualstack );
+        _process->virtual_memory.map( ( uint32 ) physical, ( uint32 ) virtualstack );
 
         // set the task state segment at the beginning of the stack.
-        state = ( State* ) ( stack + stack_size - sizeof(State) );
+        state = ( State* ) ( physical + stack_size - sizeof(State) );
       }
       else
       {
@@ -46,16 +109,26 @@ namespace kernel {
       state->ESI = 0;
       state->EDI = 0;
       state->EBP = ( uint32 ) virtualstack;
-      state->ESP = ( uint32 ) ( virtualstack + stack_size );
+      state->ESP = ( uint32 ) &thread_return; // the return address of a kernel thread function
       state->EIP = func;
 
       // set our code and data segment
-      state->CS = 0x08;
-      state->SS = 0x10;
-      state->DS = 0x10;
-      state->ES = 0x10;
-      state->FS = 0x10;
-      state->GS = 0x10;
+      if ( _process->usermode ) {
+        state->CS = System::UserCode;
+        state->SS = System::KernelData; // popped before the iret, still in ring 0
+        state->DS = System::UserData;
+        state->ES = System::UserData;
+        state->FS = System::UserData;
+        state->GS = System::UserData;
+      }
+      else {
+        state->CS = 0x08;
+        state->SS = 0x10;
+        state->DS = 0x10;
+        state->ES = 0x10;
+        state->FS = 0x10;
+        state->GS = System::PerCPUSelector;
+      }
 
       asm volatile("movl %%cr0, %0": "=b"(state->cr0));
       if ( _process->virtual_memory.page_directoies )
@@ -65,14 +138,28 @@ namespace kernel {
       // enable irq's
       state->EFLAGS = 1 << 9;
 
-      state->para = ( uint32 ) this; // take the pointer of this Thread as parameter.
+      if ( _process->usermode ) {
+        // the iret to ring 3 switches to the user stack
+        state->ESP = ( uint32 ) ( virtualstack + stack_size );
+        state->userSS = System::UserData;
+      }
+      else {
+        state->para = ( uint32 ) this; // take the pointer of this Thread as parameter.
 
-      // set stack to the virtual stack address
-      state = ( State* ) ( virtualstack + stack_size - sizeof(State) );
+        // set stack to the virtual stack address
+        state = ( State* ) ( virtualstack + stack_size - sizeof(State) );
+      }
     }
 
+    // the dispatcher walks the plan in the timer interrupt
+    bool irq = lib::cli();
+
     _process->threads.pushBack( this );
+    lib::sync::fetch_add( &_process->living, 1 );
     system->plan->push( this );
+
+    if ( irq )
+      lib::sti();
   }
 
   Thread::Thread( Process* P, uint32 Entry, uint32 StackSize )
@@ -85,6 +172,25 @@ namespace kernel {
     init();
   }
 
+  void* Thread::operator new( uint32 size ) {
+    void* t = 0;
+
+    if ( size == sizeof(Thread) )
+      t = Reaper::takeThread();
+
+    if ( t == 0 )
+      return ::operator new( size );
+
+    lib::memset( t, 0, size );
+
+    return t;
+  }
+
+  void Thread::operator delete( void* t, uint32 size ) {
+    if ( size != sizeof(Thread) || not Reaper::keepThread( t ) )
+      ::operator delete( t );
+  }
+
   uint32 Thread::id() const {
     return _id;
   }
@@ -93,31 +199,253 @@ namespace kernel {
     return _process;
   }
 
+  Thread* Thread::current() {
+    return PerCPU::thread();
+  }
+
   void Thread::join() {
-    while ( mode != DEAD ) {
-      yield();
+    Joiner j;
+    bool irq = lib::cli();
+
+    join_lock.enter();
+
+    // kill() sets DEAD before it takes the joiners, so we are either taken or done
+    if ( mode == DEAD )
+      j.done = 1;
+    else {
+      j.done = 0;
+      j.next = joiners;
+      joiners = &j;
+    }
+
+    join_lock.leave();
+
+    if ( irq )
+      lib::sti();
+
+    while ( not j.done ) {
+      Futex::wait( &j.done, 0 );
     }
   }
 
   void Thread::yield() {
+    Thread* self = current();
+
+    if ( self )
+      self->yielded = true;
+
     asm volatile( "int $0x20;" );
     // interrupt 32(0x20) is the timer interrupt which invokes the dispatcher
   }
 
+  void Thread::yieldLower() {
+    Thread* self = current();
+
+    if ( self )
+      self->aside = true;
+
+    yield();
+  }
+
+  void Thread::wakeup() {
+    if ( mode == BLOCKED ) {
+      uint64 now = lib::rdtsc();
+
+      usage.wait += now - stamp;
+      stamp = now;
+      mode = READY;
+
+      Thread* waker = current();
+      Trace::log( Trace::Wakeup, waker ? waker->_id : 0, _id );
+    }
+  }
+
+  uint64 Thread::size() {
+    return sizeof(Usage);
+  }
+
+  uint32 Thread::read( void* data, uint32 length ) {
+    Usage u = usage;
+
+    if ( length > sizeof(Usage) )
+      length = sizeof(Usage);
+
+    lib::memcpy( data, &u, length );
+
+    return length;
+  }
+
   void Thread::sleep( uint32 mircosec ) {
-    //todo sleep not implemented
+    Thread* self = current();
+    uint64 until = lib::rdtsc() + ( uint64 ) mircosec * ( system->shared->tsc_khz / 1000 );
+    bool irq = lib::cli();
+
+    // nobody would dispatch us, so spin
+    if ( self == 0 || not irq ) {
+      if ( irq )
+        lib::sti();
+
+      while ( lib::rdtsc() < until )
+        lib::sync::relax();
+
+      return;
+    }
+
+    sleep_lock.enter();
+
+    self->wake_at = until;
+    self->sleep_next = sleepers;
+    sleepers = self;
+    self->mode = BLOCKED;
+
+    sleep_lock.leave();
+
+    do {
+      yield();
+    } while ( self->mode == BLOCKED );
+
+    lib::sti();
+  }
+
+  void Thread::alarm( uint64 now ) {
+    if ( sleepers == 0 )
+      return;
+
+    sleep_lock.enter();
+
+    Thread** p = &sleepers;
+
+    while ( *p ) {
+      Thread* t = *p;
+
+      if ( now >= t->wake_at ) {
+        *p = t->sleep_next;
+        t->sleep_next = 0;
+        t->wakeup();
+      }
+      else
+        p = &t->sleep_next;
+    }
+
+    sleep_lock.leave();
+  }
+
+  /**
+   * FXSAVE needs a 16 byte aligned area.
+   */
+  static inline uint8* fpu_area( uint8* fpu ) {
+    return ( uint8* ) ( ( ( uint32 ) fpu + 15 ) & ~15 );
+  }
+
+  void Thread::saveFPU() {
+    if ( fpu == 0 )
+      fpu = new uint8[ FPUSize + 16 ];
+
+    if ( System::fxsr )
+      asm volatile("fxsave (%0)":: "r"( fpu_area( fpu ) ): "memory");
+    else
+      asm volatile("fnsave (%0)":: "r"( fpu_area( fpu ) ): "memory");
+  }
+
+  void Thread::restoreFPU() {
+    if ( fpu == 0 ) {
+      uint32 mxcsr = 0x1f80; // all sse exceptions masked
+
+      asm volatile("fninit");
+
+      if ( System::fxsr )
+        asm volatile("ldmxcsr %0":: "m"( mxcsr ));
+    }
+    else if ( System::fxsr )
+      asm volatile("fxrstor (%0)":: "r"( fpu_area( fpu ) ): "memory");
+    else
+      asm volatile("frstor (%0)":: "r"( fpu_area( fpu ) ): "memory");
   }
 
   void Thread::kill() {
-    mode = DEAD;
+    if ( lib::sync::exchange( ( volatile uint32* ) &mode, DEAD ) == DEAD )
+      return;
+
+    bool irq = lib::cli();
+
+    join_lock.enter();
+
+    Joiner* j = joiners;
+
+    joiners = 0;
+
+    join_lock.leave();
+
+    if ( irq )
+      lib::sti();
+
+    while ( j ) {
+      // the joiner may return as soon as it sees done
+      Joiner* n = j->next;
+
+      j->done = 1;
+      Futex::wake( &j->done, Futex::All );
+
+      j = n;
+    }
+
+    Reaper::bury( this );
+  }
+
+  void Thread::exit( void* result ) {
+    Thread* self = current();
+
+    self->result = result;
+    self->kill();
+
+    while ( true ) {
+      yield();
+    }
   }
 
   Thread::~Thread() {
-    if ( stack_size )
-      delete stack;
+    bool irq = lib::cli();
 
     _process->threads.remove( this );
+    _process->usage.add( usage );
+    Deadline::leave( this );
     system->plan->remove( this );
+
+    // a thread killed in sleep() is still among the sleepers
+    sleep_lock.enter();
+
+    for ( Thread** p = &sleepers; *p; p = &( *p )->sleep_next ) {
+      if ( *p == this ) {
+        *p = sleep_next;
+        break;
+      }
+    }
+
+    sleep_lock.leave();
+
+    if ( system->fpu_owner == this )
+      system->fpu_owner = 0;
+
+    if ( irq )
+      lib::sti();
+
+    if ( stack_size ) {
+      bool cached = stack_size == DefaultStackSize && _process->virtual_memory.page_directoies == 0
+          && Reaper::keepStack( stack );
+
+      if ( not cached )
+        _process->virtual_memory.free( stack );
+    }
+
+    if ( fpu )
+      delete[] fpu;
+
+    if ( ring0_stack )
+      system->virtual_memory.free( ring0_stack );
+
+    // the last one lets ~Process free the process
+    if ( lib::sync::fetch_add( &_process->living, ( uint32 ) -1 ) == 1 )
+      Futex::wake( &_process->living, Futex::All );
   }
 
 }
@@ -10,9 +10,13 @@
 
 #include <cpp.hpp>
 #include <kernel/Process.hpp>
+#include <kernel/Usage.hpp>
+#include <kernel/Deadline.hpp>
 #include <lib/File.hpp>
 #include <lib/String.hpp>
+#include <lib/std.hpp>
 #include <lib/sync/Mutex.hpp>
+#include <lib/sync/TicketLock.hpp>
 
 namespace kernel {
 
@@ -51,6 +55,12 @@ namespace kernel {
    * kernel::Thread *thread = new kernel::Thread( process, &dummy );
    * @endcode
    *
+   * @section threadaccounting CPU Accounting
+   * Every switch between ring 3 and ring 0, every dispatch and every
+   * wakeup charges the TSC cycles since the last such event to one bucket
+   * of the Usage of the thread. Reading the thread as a lib::File returns
+   * its Usage record.
+   *
    * @since 26.07.2010
    * @author Arne Simon => email::[arne_simon@gmx.de]
    */
@@ -60,6 +70,11 @@ namespace kernel {
     public:
       typedef void*(*Func)();
 
+      static const uint32 DefaultStackSize = 4000;
+      static const uint32 Ring0StackSize = 8192; ///< The kernel stack of a thread in a user mode process.
+      static const uint8 IdlePriority = 0; ///< Runs only while no other thread is ready, like the idle kernel thread.
+      static const uint8 NormalPriority = 10; ///< The priority of a new thread.
+
       enum Mode {
         READY, ///< The thread is ready for work, but is not executed.
         BLOCKED, ///< The thread is not capable to be executed by the lack of resources.
@@ -102,27 +117,59 @@ namespace kernel {
           uint32 EIP;
           uint32 CS;
           uint32 EFLAGS;
-          uint32 ESP;
+          uint32 ESP; ///< Only popped by an iret to ring 3, a kernel thread finds its return address here.
 
           // stack parameters
 
-          uint32 para; ///< A paramter for the thread. In most cases it is a pointer to our Thread-class!
+          union {
+              uint32 para; ///< A paramter for the thread. In most cases it is a pointer to our Thread-class!
+              uint32 userSS; ///< The stack segment popped by an iret to ring 3.
+          };
       };
 
       struct Behavior {
           uint8 duration; ///< The number of continous time slices. min = 1 | max = 254
           uint8 step; ///< The count of current continous time slices. min = 1 | max = 254
           uint8 priority; ///< Tells how important the thread is. min = 0 | max = 254
+          uint8 inherited; ///< The highest priority of the threads waiting on a mutex held by this thread.
+      };
+
+      /**
+       * A thread in join(), on its own stack, so the word outlives the joined thread.
+       */
+      struct Joiner {
+          volatile uint32 done; ///< The futex word.
+          Joiner* next;
       };
 
+      static lib::sync::TicketLock join_lock; ///< Guards the joiners of all threads, taken with interrupts off.
+      static Thread* sleepers; ///< The threads in sleep(), unsorted.
+      static lib::sync::TicketLock sleep_lock; ///< Guards the sleepers, taken with interrupts off.
+
     public:
       Process* _process; ///< The process of the thread.
       uint32 _id; ///< The id of the thread.
       uint32 func; ///< The function to execute.
-      uint8* stack; ///< The threads's stack. The address is the end of the stack, so it's the beginning of the memory area!
+      uint8* stack; ///< The threads's stack, virtual in its process. The address is the end of the stack, so it's the beginning of the memory area!
       uint32 stack_size; ///< The size of the stack for this thread.
       void* result; ///< The return value of the thread.
-      lib::sync::Mutex* mutex; ///< One thread can only acquire on mutex at a time. This is this mutex or null.
+      lib::sync::Mutex* mutex; ///< The last acquired mutex, all held mutexes are chained by the mutexes themself, or null.
+      lib::sync::Mutex* blocked_on; ///< The mutex the thread is parked on, or null.
+      Thread* wait_next; ///< The next thread in the lib::sync::WaitQueue this thread is parked in.
+      uint32 futex_key; ///< The Futex the thread waits on, if it is parked by Futex::wait.
+      Thread* zombie_next; ///< The next dead thread, while the thread waits for the Reaper.
+      Joiner* joiners; ///< The threads waiting for this one to die.
+      Thread* sleep_next; ///< The next thread in the sleepers.
+      uint64 wake_at; ///< The TSC at which a sleeping thread is woken.
+      uint8* ring0_stack; ///< The kernel stack for interrupts and system calls of a user mode thread, or null.
+      uint8* fpu; ///< The memory for the FPU/SSE registers, allocated on the first FPU usage, or null.
+      Usage usage; ///< The cpu usage of the thread.
+      uint64 stamp; ///< The TSC of the last accounting event.
+      bool yielded; ///< The thread gave up the cpu by yield(), the next switch is voluntary.
+      bool aside; ///< The thread gave up the cpu by yieldLower(), the next dispatch prefers any other ready thread.
+      Deadline::Reservation realtime; ///< The reservation in the Deadline class, the runtime is 0 for time sharing threads.
+
+      static const uint32 FPUSize = 512; ///< Size of the FXSAVE area.
 
       /**
        * Sets up the thread parameters.
@@ -139,14 +186,24 @@ namespace kernel {
        * @param Entry Pointer to a function.
        * @param StackSize The size of the stack for this thread.
        */
-      Thread( Process* P, uint32 Entry, uint32 StackSize = 4000 );
+      Thread( Process* P, uint32 Entry, uint32 StackSize = DefaultStackSize );
 
       /**
        * This constructor is  for inheritance, where the subclass overrides the execute function.
        *
        * @param StackSize The size of the stack for this thread.
        */
-      Thread( Process*P, uint32 StackSize = 4000 );
+      Thread( Process*P, uint32 StackSize = DefaultStackSize );
+
+      /**
+       * Takes a thread object from the cache of the Reaper, if possible.
+       */
+      static void* operator new( uint32 size );
+
+      /**
+       * Keeps the thread object in the cache of the Reaper, if possible.
+       */
+      static void operator delete( void* t, uint32 size );
 
       /**
        * Returns the id of this thread.
@@ -156,28 +213,126 @@ namespace kernel {
 
       Process* process() const;
 
+      /**
+       * The effective priority, which is used by the dispatcher.
+       *
+       * @return The own or the inherited priority, whichever is higher.
+       */
+      uint8 priority() const {
+        return behavior.inherited > behavior.priority ? behavior.inherited : behavior.priority;
+      }
+
+      /**
+       * The thread which is currently executed.
+       *
+       * @return The current thread or null, if the scheduler is not running yet.
+       */
+      static Thread* current();
+
+      /**
+       * Blocks the calling thread until this thread is dead.
+       *
+       * The joiner waits on a word of its own, the dead thread may be
+       * reaped meanwhile. Only the call itself needs the thread object.
+       */
       void join();
 
       static void yield();
 
       /**
-       * Sleeps, does nothing, for a given amount of time.
+       * Gives the cpu to the next ready thread, even one with a lower
+       * priority. yield() would pick the caller again, if it has the
+       * highest priority. Without another ready thread the caller goes on.
+       */
+      static void yieldLower();
+
+      /**
+       * Makes a BLOCKED thread ready again.
+       */
+      void wakeup();
+
+      /**
+       * Blocks the calling thread for at least the given time.
        *
-       * @todo Sleep is not implemented.
+       * The dispatcher wakes the sleepers whose time is over, so a sleep
+       * lasts until the next timer tick after it. Without a scheduler or
+       * with the interrupts off the caller spins instead.
        *
        * @param mircosec The time a thread sleeps.
        */
       static void sleep( uint32 mircosec );
 
+      /**
+       * Wakes the sleepers whose time is over, called by the dispatcher.
+       *
+       * @param now The current TSC.
+       */
+      static void alarm( uint64 now );
+
+      /**
+       * Stores the FPU/SSE registers in the thread.
+       *
+       * @attention Only called by System::switchFPU, with CR0.TS cleared.
+       */
+      void saveFPU();
+
+      /**
+       * Loads the FPU/SSE registers of the thread, a thread which never used
+       * the FPU gets freshly initialized registers.
+       *
+       * @attention Only called by System::switchFPU, with CR0.TS cleared.
+       */
+      void restoreFPU();
+
       /**
        * Kills this thread.
+       *
+       * The thread is not executed anymore, its joiners are woken and it
+       * is handed over to the Reaper, which frees it.
+       *
+       * @note Safe in interrupt context.
        */
       void kill();
 
-      uint32 size() const {
-        return stack_size;
+      /**
+       * Ends the calling thread, it never returns.
+       *
+       * A thread function which returns ends up here too, with its return value.
+       *
+       * @param result The value for the joiners.
+       */
+      static void exit( void* result );
+
+      /**
+       * Charges the cycles since the last accounting event.
+       *
+       * @param user True if they were spent in ring 3.
+       */
+      void account( bool user ) {
+        uint64 now = lib::rdtsc();
+
+        if ( user )
+          usage.user += now - stamp;
+        else
+          usage.kernel += now - stamp;
+
+        stamp = now;
       }
 
+      //--- File functions ---
+
+      /**
+       * @return The size of the Usage record.
+       */
+      uint64 size();
+
+      /**
+       * Copies the Usage record of the thread.
+       *
+       * @return The copied bytes.
+       */
+      uint32 read( void* data, uint32 length );
+
       virtual ~Thread();
   };
 
@@ -0,0 +1,56 @@
+/**
+ * Trace.cpp
+ *
+ * @since 19.10.2026
+ * @author Arne Simon => email::[arne_simon@gmx.de]
+ */
+
+#include "Trace.hpp"
+#include <kernel/System.hpp>
+
+namespace kernel {
+
+  volatile bool Trace::enabled = false;
+  Trace::Buffer Trace::buffers[ System::MaxCPUs ];
+
+  uint64 Trace::size() {
+    uint32 records = 0;
+
+    for ( uint32 c = 0; c < System::MaxCPUs; ++c ) {
+      records += buffers[ c ].head < Size ? buffers[ c ].head : Size;
+    }
+
+    return sizeof(Header) + records * sizeof(Record);
+  }
+
+  void Trace::read( void** data, uint32* length ) {
+    bool was = enabled;
+
+    enabled = false;
+
+    *length = size();
+    *data = new uint8[ *length ];
+
+    Header* h = ( Header* ) *data;
+    Record* r = ( Record* ) ( h + 1 );
+
+    h->magic = Magic;
+    h->version = Version;
+    h->cpus = System::MaxCPUs;
+    h->records = ( *length - sizeof(Header) ) / sizeof(Record);
+    h->tsc_khz = system->shared->tsc_khz;
+
+    for ( uint32 c = 0; c < System::MaxCPUs; ++c ) {
+      Buffer& b = buffers[ c ];
+      uint32 head = b.head;
+      uint32 n = head < Size ? head : Size;
+
+      for ( uint32 i = head - n; i != head; ++i ) {
+        *r++ = b.records[ i & ( Size - 1 ) ];
+      }
+    }
+
+    enabled = was;
+  }
+
+}
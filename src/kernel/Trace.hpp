@@ -0,0 +1,125 @@
+/**
+ * Trace.hpp
+ *
+ * @since 19.10.2026
+ * @author Arne Simon => email::[arne_simon@gmx.de]
+ */
+
+#ifndef KERNEL_TRACE_HPP_
+#define KERNEL_TRACE_HPP_
+
+#include <cpp.hpp>
+#include <kernel/PerCPU.hpp>
+#include <lib/File.hpp>
+#include <lib/std.hpp>
+
+namespace kernel {
+
+  /**
+   * Scheduler and interrupt event tracing.
+   *
+   * Every cpu logs into its own ring of Size records, the oldest records
+   * are overwritten. Only the owning cpu writes its ring, so a slot is
+   * reserved by an xadd without lock prefix, which is atomic against
+   * interrupts on the same cpu. A disabled trace costs one load and a
+   * branch, an enabled one about the rdtsc and five stores.
+   *
+   * Reading the trace as a lib::File returns the dump format:
+   * a Header followed by the records of all cpus, each cpu oldest first.
+   * tools/tracedecode.cpp decodes it on the host.
+   *
+   * @code
+   * kernel::Trace::enabled = true;
+   * // ... the latency spike ...
+   * kernel::Trace::enabled = false;
+   *
+   * kernel::Trace dump;
+   * void* data;
+   * uint32 length;
+   *
+   * dump.read( &data, &length ); // write it to a disk, decode it on the host
+   * @endcode
+   *
+   * @since 19.10.2026
+   * @author Arne Simon => email::[arne_simon@gmx.de]
+   */
+  class Trace: public lib::File {
+    public:
+      enum Event {
+        Dispatch = 1, ///< a = the previous thread, b = the next thread.
+        Wakeup, ///< a = the waking thread, b = the woken thread.
+        IRQEnter, ///< a = the vector, b = the interrupted thread.
+        IRQExit, ///< a = the vector, b = the thread which continues.
+        Contended ///< a = the Lock kind, b = the address of the lock.
+      };
+
+      enum Lock {
+        MutexWait, RWLockWait
+      };
+
+      /**
+       * One event, 16 bytes.
+       */
+      struct Record {
+          uint64 tsc;
+          uint8 event;
+          uint8 cpu;
+          uint16 a; ///< Thread ids are cut to 16 bit.
+          uint32 b;
+      };
+
+      struct Header {
+          uint32 magic;
+          uint16 version;
+          uint16 cpus;
+          uint32 records; ///< The number of records following the header.
+          uint32 tsc_khz; ///< To convert the timestamps, 0 if unknown.
+      };
+
+      static const uint32 Magic = 0x43525450; ///< "PTRC"
+      static const uint16 Version = 1;
+      static const uint32 Size = 4096; ///< Records per cpu, a power of two.
+
+      struct Buffer {
+          volatile uint32 head; ///< The count of all records ever logged.
+          Record records[ Size ];
+      };
+
+      static volatile bool enabled;
+      static Buffer buffers[]; ///< One ring per cpu.
+
+      static void log( uint8 event, uint16 a, uint32 b ) {
+        if ( not enabled )
+          return;
+
+        uint32 cpu = PerCPU::id();
+        Buffer& buffer = buffers[ cpu ];
+        uint32 slot = 1;
+
+        asm volatile("xaddl %0, %1": "+r"(slot), "+m"(buffer.head));
+
+        Record& r = buffer.records[ slot & ( Size - 1 ) ];
+
+        r.tsc = lib::rdtsc();
+        r.event = event;
+        r.cpu = cpu;
+        r.a = a;
+        r.b = b;
+      }
+
+      //--- File functions ---
+
+      uint64 size();
+
+      /**
+       * Dumps the rings, tracing is paused meanwhile.
+       *
+       * @param data The new dump, the caller deletes it.
+       * @param length The size of the dump.
+       */
+      void read( void** data, uint32* length );
+  };
+
+}
+
+#endif /* KERNEL_TRACE_HPP_ */
@@ -0,0 +1,54 @@
+/**
+ * Usage.hpp
+ *
+ * @since 19.10.2026
+ * @author Arne Simon => email::[arne_simon@gmx.de]
+ */
+
+#ifndef KERNEL_USAGE_HPP_
+#define KERNEL_USAGE_HPP_
+
+#include <cpp.hpp>
+
+namespace kernel {
+
+  /**
+   * The cpu usage of a Thread or a Process, all times in TSC cycles.
+   *
+   * This is the record a Thread or a Process returns by read(), divide the
+   * times by lib::SharedPage::tsc_khz to get milliseconds.
+   *
+   * @code
+   * kernel::Usage u;
+   *
+   * process->read( &u, sizeof(u) );
+   *
+   * system->video << "user " << ( uint32 ) ( u.user >> 20 ) << " Mcycles, ";
+   * system->video << "kernel " << ( uint32 ) ( u.kernel >> 20 ) << " Mcycles, ";
+   * system->video << u.involuntary << " preemptions\n";
+   * @endcode
+   *
+   * @since 19.10.2026
+   * @author Arne Simon => email::[arne_simon@gmx.de]
+   */
+  struct Usage {
+      uint64 user; ///< Time spent in ring 3.
+      uint64 kernel; ///< Time spent in ring 0, including the interrupts which hit the thread.
+      uint64 wait; ///< Time spent BLOCKED.
+      uint64 ready; ///< Time spent READY, waiting for a cpu.
+      uint32 voluntary; ///< Switches because the thread blocked, yielded or died.
+      uint32 involuntary; ///< Switches because the thread was preempted.
+
+      void add( const Usage& u ) {
+        user += u.user;
+        kernel += u.kernel;
+        wait += u.wait;
+        ready += u.ready;
+        voluntary += u.voluntary;
+        involuntary += u.involuntary;
+      }
+  };
+
+}
+
+#endif /* KERNEL_USAGE_HPP_ */
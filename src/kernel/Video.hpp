@@ -3,7 +3,7 @@
 
 #include <cpp.hpp>
 #include <lib/stream/Out.hpp>
-#include <lib/sync/Mutex.hpp>
+#include <lib/sync/TicketLock.hpp>
 
 namespace kernel {
 
@@ -19,7 +19,7 @@ namespace kernel {
       uint32 screen_color; // FB/BG-Farbe
       static const uint32 width = 80;
       static const uint32 height = 24;
-      lib::sync::Mutex _mutex;
+      lib::sync::TicketLock _mutex; // auch aus Interrupts heraus benutzt
 
     public:
       enum Color {
@@ -19,31 +19,37 @@ namespace kernel {
       blocks++;
     }
 
-    Area* a = node_get();
-
-    init( a );
-
     uint32 page = System::physical_memory.alloc( blocks );
+    uint32 start = page;
+    lib::sync::MCSLock::Node me;
 
     if ( page_directoies ) {
-      a->val = memsize; // start of the memory area
+      // reserve the range, the pages are mapped with the interrupts on
+      lock.enter( me );
+      start = memsize;
+      memsize += blocks * PhysicalMemory::PAGE_SIZE;
+      lock.leave( me );
 
       for ( uint32 p = 0; p < blocks; ++p ) {
-
-        map( page + p * PhysicalMemory::PAGE_SIZE, memsize );
-        memsize += PhysicalMemory::PAGE_SIZE;
+        map( page + p * PhysicalMemory::PAGE_SIZE, start + p * PhysicalMemory::PAGE_SIZE, page_flags );
       }
     }
-    else {
-      a->val = page;
-    }
 
+    lock.enter( me );
+
+    Area* a = node_get();
+
+    init( a );
+
+    a->val = start; // start of the memory area
     a->key = blocks * PhysicalMemory::PAGE_SIZE; // size of the memory area
 
     sizes.put( a );
+
+    lock.leave( me );
   }
 
-  void VirtualMemory::map( uint32 Physical, uint32 Virtual ) {
+  void VirtualMemory::map( uint32 Physical, uint32 Virtual, uint32 Flags ) {
     if ( page_directoies ) {
       uint32 pd_index = Virtual >> 22;
       uint32 pt_index = ( Virtual >> 12 ) & 0x03FF;
@@ -52,12 +58,13 @@ namespace kernel {
 
         uint32 addr = System::physical_memory.alloc();
 
-        page_directoies[ pd_index ] = addr | 0x02 | 0x01;
+        // the page table entries decide, who may access a page
+        page_directoies[ pd_index ] = addr | User | Writable | Present;
       }
 
       uint32* pt = ( uint32* ) ( page_directoies[ pd_index ] & 0xFFFFF000 );
 
-      pt[ pt_index ] = ( Physical & 0xFFFFF000 ) | 0x02 | 0x01;
+      pt[ pt_index ] = ( Physical & 0xFFFFF000 ) | Flags;
     }
   }
 
@@ -82,27 +89,30 @@ namespace kernel {
       lib::Exception::throwing( "VirtualMemory - allocating zero space ?!?" );
     }
 
-    mutex.enter();
+    lib::sync::MCSLock::Node me;
+    Area* node;
 
-    Area* node = sizes.find( size );
+    while ( true ) {
+      lock.enter( me );
 
-    if ( node == 0 ) {
-      node = sizes.nearest( size );
-    }
-
-    if ( node == 0 ) {
-      if ( System::physical_memory.memused < System::physical_memory.memsize ) {
-        expandForSize( size );
+      node = sizes.find( size );
 
+      if ( node == 0 ) {
         node = sizes.nearest( size );
       }
-      else {
+
+      if ( node && node->key >= size ) {
+        break;
+      }
+
+      // another thread may take the new area first, so we look again
+      lock.leave( me );
+
+      if ( System::physical_memory.memused >= System::physical_memory.memsize ) {
         lib::Exception::throwing( "VirtualMemory - no memory block of appropriate size!" );
       }
-    }
 
-    if ( node->key < size ) {
-      lib::Exception::throwing( "VirtualMemory - picked too small memory area!" );
+      expandForSize( size );
     }
 
     sizes.del( node );
@@ -133,7 +143,7 @@ namespace kernel {
 
     memused += tmp;
 
-    mutex.leave();
+    lock.leave( me );
 
     lib::memset( ( void* ) getPhysicalAddress( ptr ), 0, tmp );
 
@@ -171,9 +181,14 @@ namespace kernel {
       lib::Exception::throwing( "VirtualMemory - can not free null!" );
     }
 
+    lib::sync::MCSLock::Node me;
+
+    lock.enter( me );
+
     Area* node = addresses.find( ( uint32 ) v );
 
     if ( node == 0 ) {
+      lock.leave( me );
       lib::Exception::throwing( "VirtualMemory - freeing unknown memory area!" );
     }
 
@@ -189,6 +204,8 @@ namespace kernel {
 
     sizes.put( node );
 
+    lock.leave( me );
+
   }
 
   VirtualMemory::~VirtualMemory() {
@@ -60,6 +60,16 @@ namespace kernel {
       friend class Process;
 
     public:
+      //--- Page Flags ---
+
+      static const uint32 Present = 0x01;
+      static const uint32 Writable = 0x02;
+      static const uint32 User = 0x04; ///< Accessible from ring 3.
+
+      /**
+       * The flags for the pages mapped by alloc(), with User for processes running in ring 3.
+       */
+      uint32 page_flags;
 
       /**
        * The physical address of the page directory.
@@ -70,6 +80,9 @@ namespace kernel {
       /**
        * Expands the virtual memory size.
        *
+       * Takes the lock itself and only for the map updates, the physical
+       * allocation and the page tables are done with the interrupts on.
+       *
        * @param Size
        */
       void expandForSize( uint32 Size );
@@ -81,8 +94,9 @@ namespace kernel {
        *
        * @param Physical
        * @param Virtual
+       * @param Flags The page flags, without User only the kernel can access the page.
        */
-      void map( uint32 Physical, uint32 Virtual );
+      void map( uint32 Physical, uint32 Virtual, uint32 Flags = Present | Writable );
 
       /**
        * Returns the physical address for a virtual address.
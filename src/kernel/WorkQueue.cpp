@@ -0,0 +1,87 @@
+/**
+ * WorkQueue.cpp
+ *
+ * @since 19.10.2026
+ * @author Arne Simon => email::[arne_simon@gmx.de]
+ */
+
+#include "WorkQueue.hpp"
+#include <kernel/Futex.hpp>
+#include <kernel/ISR.hpp>
+#include <lib/sync/Atomic.hpp>
+
+namespace kernel {
+
+  WorkQueue::WorkQueue()
+      : pushed( 0 ), sleeping( 0 ), dropped( 0 ), done( 0 ) {
+    for ( uint32 i = 0; i < PriorityCount; ++i ) {
+      rings[ i ].head = 0;
+      rings[ i ].tail = 0;
+    }
+  }
+
+  bool WorkQueue::push( ISR* isr, uint32 data, Priority priority ) {
+    Ring& r = rings[ priority ];
+    uint32 tail = r.tail;
+
+    if ( tail - r.head == Size ) {
+      dropped++;
+      return false;
+    }
+
+    r.items[ tail % Size ].isr = isr;
+    r.items[ tail % Size ].data = data;
+
+    lib::sync::barrier(); // the item is written before it is published
+    r.tail = tail + 1;
+
+    lib::sync::fetch_add( &pushed, 1 );
+
+    if ( sleeping )
+      Futex::wake( &pushed, 1 );
+
+    return true;
+  }
+
+  bool WorkQueue::pop( Work& work ) {
+    for ( uint32 i = 0; i < PriorityCount; ++i ) {
+      Ring& r = rings[ i ];
+      uint32 head = r.head;
+
+      if ( head != r.tail ) {
+        lib::sync::barrier();
+        work = r.items[ head % Size ];
+
+        lib::sync::barrier(); // the item is read before the slot is given back
+        r.head = head + 1;
+
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  uint32 WorkQueue::drain() {
+    // read before looking for work, a push in between lets the wait return
+    uint32 seen = pushed;
+    uint32 n = 0;
+    Work w;
+
+    while ( n < Batch && pop( w ) ) {
+      w.isr->work( w.data );
+      n++;
+    }
+
+    done += n;
+
+    if ( n == 0 ) {
+      sleeping = 1;
+      Futex::wait( &pushed, seen );
+      sleeping = 0;
+    }
+
+    return n;
+  }
+
+}
@@ -0,0 +1,89 @@
+/**
+ * WorkQueue.hpp
+ *
+ * @since 19.10.2026
+ * @author Arne Simon => email::[arne_simon@gmx.de]
+ */
+
+#ifndef KERNEL_WORKQUEUE_HPP_
+#define KERNEL_WORKQUEUE_HPP_
+
+#include <cpp.hpp>
+
+namespace kernel {
+
+  class ISR;
+
+  /**
+   * The deferred work of one cpu.
+   *
+   * The top half of a device interrupt only acknowledges the device and
+   * pushes a work item, the bottom half ISR::work() runs later in the
+   * InterruptHandler thread of the cpu, with the interrupts enabled.
+   *
+   * Every priority class is a lock free ring buffer with one producer, the
+   * interrupts of the cpu, and one consumer, the InterruptHandler of the
+   * cpu. The items are copied into the ring, so deferring never allocates.
+   *
+   * @since 19.10.2026
+   * @author Arne Simon => email::[arne_simon@gmx.de]
+   */
+  class WorkQueue {
+    public:
+      enum Priority {
+        High, ///< Input devices and everything else with a waiting user.
+        Normal, ///< Block devices and network.
+        Low, ///< Statistics and housekeeping.
+        PriorityCount
+      };
+
+      struct Work {
+          ISR* isr; ///< The routine whose bottom half is run.
+          uint32 data; ///< A value from the top half, like a scancode or a status register.
+      };
+
+      static const uint32 Size = 64; ///< Items per priority class, a power of two.
+      static const uint32 Batch = 16; ///< Items a worker runs, before it yields the cpu.
+
+    protected:
+      struct Ring {
+          volatile uint32 head; ///< Next item to run, only written by the worker.
+          volatile uint32 tail; ///< Next free slot, only written by the top half.
+          Work items[ Size ];
+      };
+
+      Ring rings[ PriorityCount ];
+      volatile uint32 pushed; ///< Counts the pushed items, the futex word of the worker.
+      volatile uint32 sleeping; ///< The worker is parked.
+
+    public:
+      uint32 dropped; ///< Items lost because a ring was full.
+      uint32 done; ///< Items run by the worker.
+
+      WorkQueue();
+
+      /**
+       * Defers work, only called by the top halves of this cpu.
+       *
+       * @return False if the ring of the class is full and the work is dropped.
+       */
+      bool push( ISR* isr, uint32 data, Priority priority );
+
+      /**
+       * Takes the next item, the higher classes first.
+       *
+       * @return False if there is no work.
+       */
+      bool pop( Work& work );
+
+      /**
+       * Runs up to Batch items and parks the worker if there was nothing to do.
+       *
+       * @return The number of run items.
+       */
+      uint32 drain();
+  };
+
+}
+
+#endif /* KERNEL_WORKQUEUE_HPP_ */
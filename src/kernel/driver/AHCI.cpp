@@ -6,15 +6,485 @@
  */
 
 #include "AHCI.hpp"
+#include <kernel/System.hpp>
+#include <kernel/Futex.hpp>
+#include <lib/sync/Atomic.hpp>
+#include <lib/Exception.hpp>
+#include <lib/std.hpp>
 
 namespace kernel {
    namespace driver {
 
+      AHCI::Port::Port( AHCI* hba, uint8 number )
+            : regs( &hba->hba->ports[ number ] ), mask( 1 ), free( 1 ), pending( 0 ), issued( 0 ), unqueued( 0 ),
+              ahci( hba ), index( number ), ncq( false ), depth( 1 ), errors( 0 ) {
+         uint32 page = System::physical_memory.alloc();
+
+         // the command list takes the first KByte, the received FIS the 256 bytes after it
+         list = ( CommandHeader* ) page;
+         tables = ( CommandTable* ) System::physical_memory.alloc( SlotCount * sizeof(CommandTable) / PhysicalMemory::PAGE_SIZE );
+
+         lib::memset( ( void* ) page, 0, PhysicalMemory::PAGE_SIZE );
+         lib::memset( tables, 0, SlotCount * sizeof(CommandTable) );
+
+         for ( uint32 i = 0; i < SlotCount; ++i ) {
+            list[ i ].ctba = ( uint32 ) &tables[ i ];
+            state[ i ] = Idle;
+            requests[ i ] = 0;
+         }
+
+         model[ 0 ] = 0;
+         max_sectors = MaxSectors;
+         max_pages = PRDCount; // a merged chain has to fit the PRD table
+
+         disable();
+
+         regs->clb = page;
+         regs->clbu = 0;
+         regs->fb = page + 0x400;
+         regs->fbu = 0;
+         regs->serr = 0xFFFFFFFF;
+         regs->is = 0xFFFFFFFF;
+         regs->ie = PxIS_DHRS | PxIS_PSS | PxIS_DSS | PxIS_SDBS | PxIS_DPS | PxIS_Errors;
+
+         enable();
+
+         // the drive may still be busy from the reset
+         for ( uint32 i = 0; i < Timeout && ( regs->tfd & ( TFD_BSY | TFD_DRQ ) ); ++i )
+            lib::sync::relax();
+
+         if ( identify() ) {
+            mask = depth == SlotCount ? 0xFFFFFFFF : ( 1u << depth ) - 1;
+            free = mask;
+         }
+      }
+
+      void AHCI::Port::enable() {
+         for ( uint32 i = 0; i < Timeout && ( regs->cmd & PxCMD_CR ); ++i )
+            lib::sync::relax();
+
+         regs->cmd |= PxCMD_FRE;
+         regs->cmd |= PxCMD_ST;
+      }
+
+      void AHCI::Port::disable() {
+         regs->cmd &= ~PxCMD_ST;
+
+         for ( uint32 i = 0; i < Timeout && ( regs->cmd & PxCMD_CR ); ++i )
+            lib::sync::relax();
+
+         regs->cmd &= ~PxCMD_FRE;
+
+         for ( uint32 i = 0; i < Timeout && ( regs->cmd & PxCMD_FR ); ++i )
+            lib::sync::relax();
+      }
+
+      bool AHCI::Port::claim( uint32& slot ) {
+         while ( true ) {
+            uint32 f = free;
+
+            if ( f == 0 )
+               return false;
+
+            slot = __builtin_ctz( f );
+
+            if ( lib::sync::compare_exchange( &free, f, f & ~( 1u << slot ) ) == f )
+               return true;
+         }
+      }
+
+      void AHCI::Port::release( uint32 slot ) {
+         state[ slot ] = Idle;
+         requests[ slot ] = 0;
+
+         lib::sync::fetch_or( &free, 1u << slot );
+      }
+
+      uint16 AHCI::Port::map( uint32 slot, Request* r ) {
+         PRD* prd = tables[ slot ].prdt;
+         Cursor cursor( r );
+         uint16 n = 0;
+
+         while ( true ) {
+            uint32 length;
+            uint32 frame = cursor.run( length );
+
+            if ( length == 0 )
+               break;
+
+            if ( ( frame & 1 ) || ( length & 1 ) )
+               return 0;
+
+            if ( n && prd[ n - 1 ].dba + prd[ n - 1 ].dbc + 1 == frame && prd[ n - 1 ].dbc + 1 + length <= 0x400000 ) {
+               prd[ n - 1 ].dbc += length;
+            }
+            else {
+               if ( n == PRDCount )
+                  return 0;
+
+               prd[ n ].dba = frame;
+               prd[ n ].dbau = 0;
+               prd[ n ].rsv0 = 0;
+               prd[ n ].dbc = length - 1;
+               prd[ n ].rsv1 = 0;
+               prd[ n ].i = 0;
+               n++;
+            }
+
+            cursor.advance( length );
+         }
+
+         return n;
+      }
+
+      void AHCI::Port::command( uint32 slot, uint8 cmd, uint64 lba, uint32 count, bool queued ) {
+         FIS_REG_H2D* fis = ( FIS_REG_H2D* ) tables[ slot ].cfis;
+
+         lib::memset( fis, 0, sizeof(FIS_REG_H2D) );
+
+         fis->fis_type = FIS_TYPE_REG_H2D;
+         fis->c = 1;
+         fis->command = cmd;
+         fis->device = 0x40; // LBA mode
+         fis->lba0 = lba & 0xFF;
+         fis->lba1 = ( lba >> 8 ) & 0xFF;
+         fis->lba2 = ( lba >> 16 ) & 0xFF;
+         fis->lba3 = ( lba >> 24 ) & 0xFF;
+         fis->lba4 = ( lba >> 32 ) & 0xFF;
+         fis->lba5 = ( lba >> 40 ) & 0xFF;
+
+         // a count of 0 means 65536 sectors
+         if ( queued ) {
+            // FPDMA QUEUED carries the count in the features and the tag in the count
+            fis->featurel = count & 0xFF;
+            fis->featureh = ( count >> 8 ) & 0xFF;
+            fis->countl = slot << 3;
+         }
+         else {
+            fis->countl = count & 0xFF;
+            fis->counth = ( count >> 8 ) & 0xFF;
+         }
+      }
+
+      bool AHCI::Port::start( Request* r ) {
+         uint32 slot;
+         uint16 prds = 0;
+
+         bool flush = r->flags & Request::Flush;
+
+         if ( r->length > MaxSectors ) {
+            end( r, 2 );
+            return true;
+         }
+
+         // NCQ commands and the others never are in flight together
+         if ( ncq && ( ( issued | pending ) & ( flush ? 0xFFFFFFFF : unqueued ) ) )
+            return false;
+
+         if ( not claim( slot ) )
+            return false;
+
+         if ( not flush ) {
+            prds = map( slot, r );
+
+            if ( prds == 0 ) {
+               // the buffer can not be transferred by DMA
+               release( slot );
+               end( r, 1 );
+               return true;
+            }
+         }
+
+         CommandHeader& header = list[ slot ];
+
+         header.cfl = sizeof(FIS_REG_H2D) / 4;
+         header.a = 0;
+         header.w = r->direction;
+         header.p = 0;
+         header.c = 0;
+         header.prdtl = prds;
+         header.prdbc = 0;
+
+         if ( flush ) {
+            command( slot, ATA_CMD_FLUSH_CACHE_EXT, 0, 0, false );
+
+            if ( ncq )
+               lib::sync::fetch_or( &unqueued, 1u << slot );
+         }
+         else if ( ncq ) {
+            command( slot, r->direction ? ATA_CMD_WRITE_FPDMA_QUEUED : ATA_CMD_READ_FPDMA_QUEUED, r->lba, r->length, true );
+
+            if ( r->flags & Request::Fua )
+               ( ( FIS_REG_H2D* ) tables[ slot ].cfis )->device |= 0x80;
+         }
+         else if ( r->direction && ( r->flags & Request::Fua ) )
+            command( slot, ATA_CMD_WRITE_DMA_FUA_EXT, r->lba, r->length, false );
+         else
+            command( slot, r->direction ? ATA_CMD_WRITE_DMA_EXT : ATA_CMD_READ_DMA_EXT, r->lba, r->length, false );
+
+         requests[ slot ] = r;
+         state[ slot ] = Issued;
+
+         lib::sync::fetch_or( &pending, 1u << slot );
+
+         return true;
+      }
+
+      void AHCI::Port::kick() {
+         // the interrupt must not see the slots issued before the HBA does
+         lock.enter();
+
+         uint32 bits = lib::sync::exchange( &pending, 0 );
+
+         if ( bits ) {
+            issued |= bits;
+
+            // a FLUSH is no NCQ command, its slot in PxSACT would never be cleared
+            uint32 queued = ncq ? bits & ~unqueued : 0;
+
+            if ( queued )
+               regs->sact = queued;
+
+            regs->ci = bits;
+         }
+
+         lock.leave();
+      }
+
+      void AHCI::Port::poll() {
+         complete();
+      }
+
+      void AHCI::Port::complete() {
+         Request* done[ SlotCount ];
+         uint8 error[ SlotCount ];
+         uint32 n = 0;
+
+         lock.enter();
+
+         uint32 status = regs->is;
+
+         regs->is = status;
+         ahci->hba->is = 1u << index;
+
+         // a slot is done when it left the command issue and, for NCQ, the active tags
+         uint32 active = regs->ci | regs->sact;
+         uint32 finished = issued & ~active;
+         uint32 failed = 0;
+
+         if ( status & PxIS_Errors ) {
+            failed = issued & active;
+
+            // stopping the port clears PxCI and PxSACT, the commands in flight are lost
+            disable();
+            regs->serr = 0xFFFFFFFF;
+            regs->is = 0xFFFFFFFF;
+            enable();
+         }
+
+         issued &= ~( finished | failed );
+         lib::sync::fetch_and( &unqueued, ~( finished | failed ) );
+
+         for ( uint32 i = 0; i < SlotCount; ++i ) {
+            uint32 bit = 1u << i;
+
+            if ( not ( ( finished | failed ) & bit ) )
+               continue;
+
+            if ( failed & bit )
+               errors++;
+
+            if ( requests[ i ] ) {
+               done[ n ] = requests[ i ];
+               error[ n ] = ( failed & bit ) ? 1 : 0;
+               n++;
+
+               release( i );
+            }
+            else {
+               // an internal command, its issuer releases the slot
+               state[ i ] = ( failed & bit ) ? Failed : Done;
+               Futex::wake( &state[ i ], 1 );
+            }
+         }
+
+         lock.leave();
+
+         // ending starts the next requests, which takes the lock again
+         for ( uint32 i = 0; i < n; ++i )
+            end( done[ i ], error[ i ] );
+      }
+
+      bool AHCI::Port::identify() {
+         uint16* data = ( uint16* ) System::physical_memory.alloc();
+         uint32 slot;
+
+         if ( not claim( slot ) )
+            return false;
+
+         CommandHeader& header = list[ slot ];
+
+         header.cfl = sizeof(FIS_REG_H2D) / 4;
+         header.w = 0;
+         Request buffer; // only describes the page for map()
+
+         buffer.prepare( Request::Read, 0 );
+         buffer.add( data, 512 );
+
+         header.prdtl = map( slot, &buffer );
+         header.prdbc = 0;
+
+         command( slot, ATA_CMD_IDENTIFY, 0, 0, false );
+
+         state[ slot ] = Issued;
+         lib::sync::fetch_or( &pending, 1u << slot );
+
+         kick();
+
+         if ( lib::interrupts() ) {
+            while ( state[ slot ] == Issued )
+               Futex::wait( &state[ slot ], Issued );
+         }
+         else {
+            // nobody takes the interrupt, e.g. while booting
+            while ( state[ slot ] == Issued ) {
+               complete();
+               lib::sync::relax();
+            }
+         }
+
+         bool ok = state[ slot ] == Done;
+
+         release( slot );
+
+         if ( ok ) {
+            ncq = ( ahci->hba->cap & CAP_SNCQ ) && ( data[ 76 ] & 0x100 );
+
+            // without NCQ the HBA runs the issued commands one after another
+            depth = ncq ? lib::min( ( uint32 ) ( data[ 75 ] & 0x1F ) + 1, ahci->slots ) : ahci->slots;
+
+            if ( data[ 83 ] & 0x400 )
+               size = *( uint64* ) ( data + 100 ) & 0xFFFFFFFFFFFFull; // 48 bit addressing
+            else
+               size = *( uint32* ) ( data + 60 );
+
+            for ( uint32 k = 0; k < 40; k += 2 ) {
+               model[ k ] = ( ( uint8* ) data )[ 54 + k + 1 ];
+               model[ k + 1 ] = ( ( uint8* ) data )[ 54 + k ];
+            }
+            model[ 40 ] = 0;
+         }
+
+         System::physical_memory.free( data );
+
+         return ok;
+      }
+
+      AHCI::Port::~Port() {
+         disable();
+
+         System::physical_memory.free( list );
+         System::physical_memory.free( tables );
+      }
+
       AHCI::AHCI( PCI::Device* dev ) {
+         _device = dev;
+         hba = ( volatile HBA* ) ( _device->config.standart.bar5_addr & 0xFFFFFFF0 );
+
+         for ( uint32 i = 0; i < 32; ++i )
+            ports[ i ] = 0;
+
+         _device->enable( PCI::CMD_Memory_Space | PCI::CMD_Bus_Master );
+
+         hba->ghc |= GHC_AE;
+
+         slots = ( ( hba->cap & CAP_NCS ) >> 8 ) + 1;
 
+         // the ports complete by polling until the interrupt is attached
+         for ( uint8 i = 0; i < 32; ++i ) {
+            volatile PortRegisters* p = &hba->ports[ i ];
+
+            if ( not ( hba->pi & ( 1u << i ) ) )
+               continue;
+
+            if ( ( p->ssts & SSTS_DET ) != SSTS_DET_PRESENT || p->sig != SIG_ATA )
+               continue;
+
+            ports[ i ] = new Port( this, i );
+         }
+
+         hba->is = 0xFFFFFFFF;
+
+         system->attach( System::PIC_Master_Offset + _device->config.standart.interrupt_line, this );
+
+         hba->ghc |= GHC_IE;
+
+         // Print Summary:
+         system->video.color( Video::LightBlue );
+         for ( uint32 i = 0; i < 32; ++i ) {
+            if ( ports[ i ] ) {
+               system->video << "SATA Drive " << ( uint32 ) ( ports[ i ]->size >> 11 ) << "MByte";
+               system->video << ( ports[ i ]->ncq ? " NCQ " : " " ) << ports[ i ]->depth;
+               system->video << " - " << ports[ i ]->model << "\n";
+            }
+         }
+         system->video.color( Video::LightGrey );
+      }
+
+      bool AHCI::call() {
+         uint32 status = hba->is;
+
+         if ( status == 0 )
+            return false;
+
+         // a coalesced interrupt has its own bit, it stands for all ports
+         if ( ( hba->ccc_ctl & CCC_EN ) && ( status & ( 1u << ( ( hba->ccc_ctl >> 3 ) & 0x1F ) ) ) )
+            status |= hba->ccc_ports;
+
+         for ( uint32 i = 0; i < 32; ++i ) {
+            if ( not ( status & ( 1u << i ) ) )
+               continue;
+
+            if ( ports[ i ] )
+               ports[ i ]->complete();
+            else
+               hba->is = 1u << i;
+         }
+
+         return true;
+      }
+
+      bool AHCI::coalesce( uint8 completions, uint16 milliseconds ) {
+         if ( not ( hba->cap & CAP_CCCS ) )
+            return false;
+
+         uint32 coalesced = 0;
+
+         for ( uint32 i = 0; i < 32; ++i ) {
+            if ( ports[ i ] )
+               coalesced |= 1u << i;
+         }
+
+         // the HBA takes the settings only while coalescing is off
+         hba->ccc_ctl &= ~CCC_EN;
+
+         if ( completions == 0 )
+            return true;
+
+         hba->ccc_ports = coalesced;
+         hba->ccc_ctl = ( ( uint32 ) milliseconds << 16 ) | ( ( uint32 ) completions << 8 );
+         hba->ccc_ctl |= CCC_EN;
+
+         return true;
       }
 
       AHCI::~AHCI() {
+         hba->ghc &= ~GHC_IE;
+
+         system->detach( System::PIC_Master_Offset + _device->config.standart.interrupt_line, this );
+
+         for ( uint32 i = 0; i < 32; ++i )
+            delete ports[ i ];
       }
 
    } /* namespace driver */
@@ -14,33 +14,37 @@ namespace kernel {
 
   namespace driver {
 
-    bool ATA::MBR::isValid() {
-      return validation[ 0 ] == 0x55 && validation[ 1 ] == 0xAA;
-    }
-
-    uchar ATA::Drive::access( uint8 direction, uint32 lba, uint8 numsects, void* edi ) {
+    void ATA::Drive::access() {
+      ChannelRegisters& c = ata->channels[ channel ];
       uint8 lba_mode /* 0: CHS, 1:LBA28, 2: LBA48 */, dma /* 0: No DMA, 1: DMA */, cmd;
       uint8 lba_io[ 6 ];
+      uint8 direction = c.request->direction ? ATA_WRITE : ATA_READ;
       uint32 slavebit = drive; // Read the Drive [Master/Slave]
-      uint32 bus = ata->channels[ channel ].base; // Bus Base, like 0x1F0 which is also data port.
-      uint32 words = 256; // Almost every ATA drive has a sector-size of 512-byte.
-      uint16 cyl, i;
-      uint8 head, sect, err;
-      ata->irq_invoked = 0x02;
+      uint64 lba = c.lba;
+      uint32 numsects = lib::min( c.left, lba48() ? MaxSectorsLBA48 : MaxSectorsLBA28 );
+      uint32 bytes = numsects * SectorSize;
+      uint16 cyl;
+      uint8 head, sect;
+
+      ata->write( channel, ATA_REG_CONTROL, c.nIEN );
+
+      dma = this->dma && ata->prepare( channel, direction, c.cursor, bytes );
 
-      ata->write( channel, ATA_REG_CONTROL, ata->channels[ channel ].nIEN = 0x02 );
+      // a full PRD table shortens the command to what it maps
+      if ( dma )
+        numsects = bytes / SectorSize;
 
       // (I) Select one from LBA28, LBA48 or CHS;
-      if ( lba >= 0x10000000 ) { // Sure Drive should support LBA in this case, or you are
+      if ( lba + numsects > 0x10000000 || numsects > 256 ) { // Sure Drive should support LBA48 in this case, or you are
         // giving a wrong LBA.
         // LBA48:
         lba_mode = 2;
-        lba_io[ 0 ] = ( lba & 0x000000FF ) >> 0;
-        lba_io[ 1 ] = ( lba & 0x0000FF00 ) >> 8;
-        lba_io[ 2 ] = ( lba & 0x00FF0000 ) >> 16;
-        lba_io[ 3 ] = ( lba & 0xFF000000 ) >> 24;
-        lba_io[ 4 ] = 0; // LBA28 is integer, so 32-bits are enough to access 2TB.
-        lba_io[ 5 ] = 0; // LBA28 is integer, so 32-bits are enough to access 2TB.
+        lba_io[ 0 ] = ( lba >> 0 ) & 0xFF;
+        lba_io[ 1 ] = ( lba >> 8 ) & 0xFF;
+        lba_io[ 2 ] = ( lba >> 16 ) & 0xFF;
+        lba_io[ 3 ] = ( lba >> 24 ) & 0xFF;
+        lba_io[ 4 ] = ( lba >> 32 ) & 0xFF;
+        lba_io[ 5 ] = ( lba >> 40 ) & 0xFF;
         head = 0; // Lower 4-bits of HDDEVSEL are not used here.
       }
       else if ( capabilities & 0x200 ) { // Drive supports LBA?
@@ -55,21 +59,21 @@ namespace kernel {
         head = ( lba & 0xF000000 ) >> 24;
       }
       else {
-        // CHS:
+        // CHS, the LBA is below 2^28 here:
+        uint32 l = ( uint32 ) lba;
+
         lba_mode = 0;
-        sect = ( lba % 63 ) + 1;
-        cyl = ( lba + 1 - sect ) / ( 16 * 63 );
+        sect = ( l % 63 ) + 1;
+        cyl = ( l + 1 - sect ) / ( 16 * 63 );
         lba_io[ 0 ] = sect;
         lba_io[ 1 ] = ( cyl >> 0 ) & 0xFF;
         lba_io[ 2 ] = ( cyl >> 8 ) & 0xFF;
         lba_io[ 3 ] = 0;
         lba_io[ 4 ] = 0;
         lba_io[ 5 ] = 0;
-        head = ( lba + 1 - sect ) % ( 16 * 63 ) / ( 63 ); // Head number is written to HDDEVSEL lower 4-bits.
+        head = ( l + 1 - sect ) % ( 16 * 63 ) / ( 63 ); // Head number is written to HDDEVSEL lower 4-bits.
       }
 
-      dma = 0; // we don't support DMA yet!!
-
       // wait if the drive is busy
       while ( ata->read( channel, ATA_REG_STATUS ) & ATA_SR_BSY )
         ;
@@ -81,13 +85,14 @@ namespace kernel {
         ata->write( channel, ATA_REG_HDDEVSEL, 0xE0 | ( slavebit << 4 ) | head ); // Drive & LBA
 
       // write parameters
+      // a count of 0 means 256 sectors, and 65536 with LBA48
       if ( lba_mode == 2 ) {
-        ata->write( channel, ATA_REG_SECCOUNT1, 0 );
+        ata->write( channel, ATA_REG_SECCOUNT1, ( numsects >> 8 ) & 0xFF );
         ata->write( channel, ATA_REG_LBA3, lba_io[ 3 ] );
         ata->write( channel, ATA_REG_LBA4, lba_io[ 4 ] );
         ata->write( channel, ATA_REG_LBA5, lba_io[ 5 ] );
       }
-      ata->write( channel, ATA_REG_SECCOUNT0, numsects );
+      ata->write( channel, ATA_REG_SECCOUNT0, numsects & 0xFF );
       ata->write( channel, ATA_REG_LBA0, lba_io[ 0 ] );
       ata->write( channel, ATA_REG_LBA1, lba_io[ 1 ] );
       ata->write( channel, ATA_REG_LBA2, lba_io[ 2 ] );
@@ -117,104 +122,133 @@ namespace kernel {
       if ( lba_mode == 2 && dma == 1 && direction == 1 )
         cmd = ATA_CMD_WRITE_DMA_EXT;
 
+      c.phase = Transfer;
+      c.dma = dma;
+      c.sectors = numsects;
+      c.moved = 0;
+      c.bytes = bytes;
+
       ata->write( channel, ATA_REG_COMMAND, cmd );
 
-      if ( dma )
-        if ( direction == 0 ) {
-          // DMA Read.
-        }
-        else {
-          // DMA Write.
-        }
-      else if ( direction == 0 )
-        // PIO Read.
-        for ( i = 0; i < numsects; i++ ) {
-          // polling, set error and exit if there is
-          if ( ( err = ata->polling( channel, 1 ) ) )
-            return err;
+      if ( dma ) {
+        ata->write( channel, ATA_REG_BMCOMMAND, ata->read( channel, ATA_REG_BMCOMMAND ) | ATA_BM_START );
+      }
+      else if ( direction == ATA_WRITE ) {
+        // PIO Write, the first sector is requested without an interrupt,
+        // every following one and the end of the command interrupt.
+        ata->polling( channel, 0 );
 
-          lib::ins( bus, ( uint32 ) edi, 2 * words );
+        pio( direction, c.cursor );
+        c.moved = 1;
+      }
 
-          edi = ( void* ) ( ( uint32 ) edi + ( words * 2 ) );
-        }
-      else {
-        // PIO Write.
-        for ( i = 0; i < numsects; i++ ) {
-          // polling, set error and exit if there is
-          if ( ( err = ata->polling( channel, 0 ) ) )
-            return err;
+      ata->delay( channel );
+    }
 
-          lib::outs( bus, ( uint32 ) edi, 2 * words );
+    void ATA::Drive::pio( uint8 direction, Cursor& cursor ) {
+      uint32 bus = ata->channels[ channel ].base;
 
-          edi = ( void* ) ( ( uint32 ) edi + ( words * 2 ) );
-        }
+      // the sector of a buffer which is not sector aligned spans two pages
+      for ( uint32 left = SectorSize; left; ) {
+        uint32 bytes;
+        uint32 frame = cursor.run( bytes );
+
+        if ( bytes == 0 )
+          break;
+
+        bytes = lib::min( bytes, left );
 
-        ata->write( channel, ATA_REG_COMMAND, (uint8 []) {ATA_CMD_CACHE_FLUSH,
-          ATA_CMD_CACHE_FLUSH,
-          ATA_CMD_CACHE_FLUSH_EXT}[ lba_mode ] );
+        if ( direction == ATA_WRITE )
+          lib::outs( bus, frame, bytes );
+        else
+          lib::ins( bus, frame, bytes );
 
-        if ( ( err = ata->polling( channel, 0 ) ) )
-          return err;
+        cursor.advance( bytes );
+        left -= bytes;
       }
+    }
+
+    void ATA::Drive::cacheFlush() {
+      ChannelRegisters& c = ata->channels[ channel ];
+
+      ata->write( channel, ATA_REG_CONTROL, c.nIEN );
+
+      while ( ata->read( channel, ATA_REG_STATUS ) & ATA_SR_BSY )
+        ;
+
+      ata->write( channel, ATA_REG_HDDEVSEL, 0xA0 | ( drive << 4 ) );
+
+      c.phase = Flushing;
+      c.dma = false;
 
-      return 0;
+      ata->write( channel, ATA_REG_COMMAND, lba48() ? ATA_CMD_CACHE_FLUSH_EXT : ATA_CMD_CACHE_FLUSH );
+      ata->delay( channel );
     }
 
-    void ATA::Drive::readSector( uint8 numsects, uint32 lba, void* edi ) {
+    bool ATA::Drive::start( Request* r ) {
+      ChannelRegisters& c = ata->channels[ channel ];
 
       // check if the drive presents
       if ( drive > 3 || reserved == 0 ) {
         package[ 0 ] = 0x1; // drive not found!
-        lib::Exception::throwing( "ATA - drive not found!" );
+        end( r, package[ 0 ] );
+        return true;
       }
-      // check if inputs are valid
-      else if ( ( ( lba + numsects ) > size ) && ( type == PATA ) ) {
-        package[ 0 ] = 0x2; // seeking to invalid position.
-        lib::Exception::throwing( "seeking invalid position!" );
-      } // read in PIO mode through polling & IRQ
-      else {
-        uint8 err = 0;
-        if ( type == PATA ) {
-          err = access( ATA_READ, lba, numsects, edi );
-        }
-        else if ( type == PATAPI ) {
-          lib::Exception::throwing( "read ATAPI!" );
-          for ( int i = 0; i < numsects; i++ ) {
-            // err = ide_atapi_read( drive, lba + i, 1, es, edi + ( i * 2048 ) );
-          }
-        }
 
-        package[ 0 ] = print_error( err );
+      if ( type == PATAPI ) {
+        package[ 0 ] = print_error( r->direction ? 4 : 3 ); // write protected, reading ATAPI is not supported
+        end( r, package[ 0 ] );
+        return true;
       }
 
-    }
+      // somebody takes the interrupts now, before nobody could, e.g. while booting
+      if ( lib::interrupts() )
+        ata->interrupting = true;
 
-    void ATA::Drive::writeSector( uint8 numsects, uint32 lba, void* edi ) {
-      // check if the drive is present
-      if ( drive > 3 || reserved == 0 ) {
-        package[ 0 ] = 0x1; // Drive Not Found!
-      }
-      // check if inputs are valid
-      else if ( ( ( lba + numsects ) > size ) && ( type == PATA ) ) {
-        package[ 0 ] = 0x2; // Seeking to invalid position.
-      }
-      // 3: Read in PIO Mode through Polling & IRQs:
-      else {
-        uint8 err = 0;
-        if ( type == PATA )
-          err = access( ATA_WRITE, lba, numsects, edi );
-        else if ( type == PATAPI )
-          err = 4; // Write-Protected.
-        package[ 0 ] = print_error( err );
+      c.lock.enter();
+
+      // one command per channel, step() runs this drive again when the other one is done
+      if ( c.phase != Idle ) {
+        c.lock.leave();
+        return false;
       }
-    }
 
-    void ATA::Drive::read( MBR* mbr ) {
-      readSector( 1, 0, mbr );
+      c.nIEN = ata->interrupting ? 0 : 0x02;
+      c.drive = this;
+      c.request = r;
+      c.cursor = Cursor( r );
+      c.lba = r->lba;
+      c.left = r->length;
+
+      if ( r->flags & Request::Flush )
+        cacheFlush();
+      else
+        access();
+
+      c.lock.leave();
+
+      return true;
     }
 
-    void ATA::Drive::write( MBR* mbr ) {
-      writeSector( 1, 0, mbr );
+    void ATA::Drive::poll() {
+      ChannelRegisters& c = ata->channels[ channel ];
+      uint8 bmstatus = 0;
+
+      if ( c.drive != this || ( ata->read( channel, ATA_REG_ALTSTATUS ) & ATA_SR_BSY ) )
+        return;
+
+      if ( c.prdt ) {
+        bmstatus = ata->read( channel, ATA_REG_BMSTATUS );
+
+        // with nIEN set the drive may not raise the interrupt bit,
+        // then the bus master is done when it is idle and the drive is not busy anymore
+        if ( c.dma && ( bmstatus & ATA_BM_ACTIVE ) && not ( bmstatus & ( ATA_BM_IRQ | ATA_BM_ERR ) ) )
+          return;
+
+        ata->write( channel, ATA_REG_BMSTATUS, ATA_BM_IRQ );
+      }
+
+      ata->step( channel, ata->read( channel, ATA_REG_STATUS ), bmstatus ); // acknowledges the drive
     }
 
     uint8 ATA::Drive::print_error( uint8 err ) {
@@ -308,13 +342,212 @@ namespace kernel {
       initialize( _device->config.standart.bar0_addr, _device->config.standart.bar1_addr,
           _device->config.standart.bar2_addr, _device->config.standart.bar3_addr, _device->config.standart.bar4_addr );
 
+      // a controller in native mode uses its PCI line for both channels, else IRQ 14 and 15
+      for ( uint8 i = 0; i < 2; ++i ) {
+        uint8 line = _device->config.standart.bar0_addr ? _device->config.standart.interrupt_line : 14 + i;
+
+        interrupts[ i ].ata = this;
+        interrupts[ i ].channel = i;
+        interrupts[ i ].completed = 0;
+
+        system->attach( System::PIC_Master_Offset + line, &interrupts[ i ] );
+      }
+
     }
 
-    uint8 ATA::polling( uint8 channel, uint32 advanced_check ) {
+    bool ATA::prepare( uint8 channel, uint8 direction, BlockDevice::Cursor cursor, uint32& bytes ) {
+      PRD* prd = channels[ channel ].prdt;
+      uint32 mapped = 0;
+      uint32 n = 0;
 
-      // delay of 400 nanosecond
+      if ( prd == 0 )
+        return false;
+
+      while ( mapped < bytes ) {
+        uint32 rest;
+        uint32 frame = cursor.run( rest );
+
+        if ( rest == 0 )
+          break;
+
+        if ( frame & 1 )
+          return false;
+
+        uint32 length = lib::min( bytes - mapped, rest );
+
+        if ( n && prd[ n - 1 ].address + prd[ n - 1 ].bytes == frame && ( frame & ( PRDBoundary - 1 ) )
+            && prd[ n - 1 ].bytes + length < PRDBoundary ) {
+          prd[ n - 1 ].bytes += length;
+        }
+        else {
+          if ( n == PRDCount )
+            break;
+
+          prd[ n ].address = frame;
+          prd[ n ].bytes = length;
+          prd[ n ].flags = 0;
+          n++;
+        }
+
+        cursor.advance( length );
+        mapped += length;
+      }
+
+      // the command moves whole sectors, the torn one goes to the next command
+      for ( uint32 torn = mapped & ( BlockDevice::SectorSize - 1 ); torn; ) {
+        uint32 last = prd[ n - 1 ].bytes;
+
+        if ( last <= torn ) {
+          torn -= last;
+          mapped -= last;
+          n--;
+        }
+        else {
+          prd[ n - 1 ].bytes -= torn;
+          mapped -= torn;
+          torn = 0;
+        }
+      }
+
+      if ( mapped == 0 )
+        return false;
+
+      bytes = mapped;
+      prd[ n - 1 ].flags = PRD_EOT;
+
+      lib::out( channels[ channel ].bmide + ATA_REG_BMPRDT - 0x0E, ( uint32 ) prd );
+      write( channel, ATA_REG_BMCOMMAND, direction == ATA_READ ? ATA_BM_READ : 0 );
+      write( channel, ATA_REG_BMSTATUS, ATA_BM_ERR | ATA_BM_IRQ ); // cleared by writing ones
+
+      return true;
+    }
+
+    bool ATA::Interrupt::call() {
+      ChannelRegisters& c = ata->channels[ channel ];
+      uint8 bmstatus = 0;
+
+      if ( c.prdt ) {
+        bmstatus = ata->read( channel, ATA_REG_BMSTATUS );
+
+        // the bus master mirrors the interrupt line of its channel for PIO and DMA
+        if ( not ( bmstatus & ATA_BM_IRQ ) )
+          return false;
+
+        ata->write( channel, ATA_REG_BMSTATUS, ATA_BM_IRQ );
+      }
+      else if ( c.phase == Idle || ( ata->read( channel, ATA_REG_ALTSTATUS ) & ATA_SR_BSY ) ) {
+        // without bus master there is no interrupt bit, but an idle channel or a
+        // busy drive did not interrupt, e.g. the other channel on a shared line
+        return false;
+      }
+
+      completed++;
+
+      ata->step( channel, ata->read( channel, ATA_REG_STATUS ), bmstatus ); // acknowledges the drive
+
+      return true;
+    }
+
+    void ATA::step( uint8 channel, uint8 status, uint8 bmstatus ) {
+      ChannelRegisters& c = channels[ channel ];
+      uint8 err = 0;
+
+      c.lock.enter();
+
+      Drive* d = c.drive;
+
+      // nothing in flight, e.g. the interrupt of a polled command
+      if ( c.phase == Idle ) {
+        c.lock.leave();
+        return;
+      }
+
+      if ( status & ATA_SR_ERR )
+        err = 2;
+      else if ( status & ATA_SR_DF )
+        err = 1;
+
+      if ( c.dma ) {
+        write( channel, ATA_REG_BMCOMMAND, read( channel, ATA_REG_BMCOMMAND ) & ~ATA_BM_START );
+        write( channel, ATA_REG_BMSTATUS, ATA_BM_ERR | ATA_BM_IRQ ); // cleared by writing ones
+
+        if ( bmstatus & ATA_BM_ERR )
+          err = 2;
+
+        c.cursor.advance( c.bytes );
+      }
+      else if ( c.phase == Transfer && err == 0 ) {
+        if ( c.request->direction ) {
+          // the drive asks for the next sector, after the last one it ends the command
+          if ( c.moved < c.sectors ) {
+            d->pio( ATA_WRITE, c.cursor );
+            c.moved++;
+
+            delay( channel );
+            c.lock.leave();
+            return;
+          }
+        }
+        else if ( status & ATA_SR_DRQ ) {
+          // the drive interrupts once per sector it has ready
+          d->pio( ATA_READ, c.cursor );
+
+          if ( ++c.moved < c.sectors ) {
+            c.lock.leave();
+            return;
+          }
+        }
+        else
+          err = 3;
+      }
+
+      // the command is done, the chain goes on with the next one
+      if ( err == 0 && c.phase == Transfer ) {
+        c.lba += c.sectors;
+        c.left -= c.sectors;
+
+        if ( c.left ) {
+          d->access();
+          c.lock.leave();
+          return;
+        }
+
+        // the task file has no FUA write for PIO and LBA28, a flush behind the write does for all
+        if ( c.request->flags & BlockDevice::Request::Fua ) {
+          d->cacheFlush();
+          c.lock.leave();
+          return;
+        }
+      }
+
+      BlockDevice::Request* r = c.request;
+
+      d->package[ 0 ] = d->print_error( err );
+
+      c.phase = Idle;
+      c.drive = 0;
+      c.request = 0;
+
+      c.lock.leave();
+
+      d->end( r, d->package[ 0 ] );
+
+      // the other drive of the channel may have a chain waiting
+      for ( uint32 i = 0; i < 4; ++i ) {
+        if ( drives[ i ].reserved && drives[ i ].channel == channel && &drives[ i ] != d )
+          drives[ i ].run();
+      }
+    }
+
+    void ATA::delay( uint8 channel ) {
       for ( int i = 0; i < 4; i++ )
         read( channel, ATA_REG_ALTSTATUS ); // Reading the Alternate Status port wastes 100ns.
+    }
+
+    uint8 ATA::polling( uint8 channel, uint32 advanced_check ) {
+
+      // delay of 400 nanosecond
+      delay( channel );
 
       while ( read( channel, ATA_REG_STATUS ) & ATA_SR_BSY )
         ; // Wait for BSY to be zero.
@@ -407,6 +640,23 @@ namespace kernel {
       channels[ ATA_SECONDARY ].bmide = ( BAR4 & 0xFFFFFFFC ) + 8; // Bus Master IDE
       channels[ ATA_PRIMARY ].nIEN = 0x02;
       channels[ ATA_SECONDARY ].nIEN = 0x02;
+      channels[ ATA_PRIMARY ].prdt = 0;
+      channels[ ATA_SECONDARY ].prdt = 0;
+      channels[ ATA_PRIMARY ].phase = Idle;
+      channels[ ATA_SECONDARY ].phase = Idle;
+      channels[ ATA_PRIMARY ].drive = 0;
+      channels[ ATA_SECONDARY ].drive = 0;
+      channels[ ATA_PRIMARY ].request = 0;
+      channels[ ATA_SECONDARY ].request = 0;
+      interrupting = false;
+
+      // a page never crosses a 64 KByte boundary, as the bus master demands for the PRD table
+      if ( BAR4 & 0xFFFFFFFC ) {
+        _device->enable( PCI::CMD_Bus_Master );
+
+        channels[ ATA_PRIMARY ].prdt = ( PRD* ) System::physical_memory.alloc();
+        channels[ ATA_SECONDARY ].prdt = ( PRD* ) System::physical_memory.alloc();
+      }
 
       //software reset
 //         write( ATA_PRIMARY, ATA_REG_CONTROL, 6u );
@@ -479,16 +729,19 @@ namespace kernel {
           drives[ count ].drive = j;
           drives[ count ].signature = ( *( uint16* ) ( buf + ATA_IDENT_DEVICETYPE ) );
           drives[ count ].capabilities = ( *( uint16* ) ( buf + ATA_IDENT_CAPABILITIES ) );
-          drives[ count ].commandSets = ( *( uint16* ) ( buf + ATA_IDENT_COMMANDSETS ) );
+          drives[ count ].commandSets = ( *( uint32* ) ( buf + ATA_IDENT_COMMANDSETS ) ); // words 82 and 83
+          drives[ count ].dma = channels[ i ].prdt && type == PATA && ( drives[ count ].capabilities & 0x100 );
 
           // get size
           if ( drives[ count ].commandSets & ( 1 << 26 ) ) {
             // Device uses 48-Bit Addressing:
-            drives[ count ].size = *( ( uint32* ) ( buf + ATA_IDENT_MAX_LBA_EXT ) );
+            drives[ count ].size = *( ( uint64* ) ( buf + ATA_IDENT_MAX_LBA_EXT ) ) & 0xFFFFFFFFFFFFull;
+            drives[ count ].max_sectors = MaxSectorsLBA48;
           }
           else {
             // Device uses CHS or 28-bit Addressing:
             drives[ count ].size = *( ( uint32* ) ( buf + ATA_IDENT_MAX_LBA ) );
+            drives[ count ].max_sectors = MaxSectorsLBA28;
           }
 
           //  String indicates model of device (like Western Digital HDD and SONY DVD-RW...):
@@ -507,14 +760,14 @@ namespace kernel {
         if ( drives[ i ].reserved == 1 ) {
           system->video << (const char *[]) {"ATA", "ATAPI"}[ drives[ i ].type ];
 
-          int size = drives[ i ].size >> 1;
+          uint64 size = drives[ i ].size >> 1;
           int idx = 0;
 
           while ( size >= 1024 ) {
             size >>= 10; // Divided by 1024
             ++idx;
           }
-          system->video << " Drive " << size;
+          system->video << " Drive " << ( uint32 ) size;
           system->video << (const char *[]) {"KByte", "MByte", "GByte", "TByte"}[ idx ];
           system->video << " - " << drives[ i ].model << "\n";
         }
@@ -9,7 +9,9 @@
 #define KERNEL_ATA_HPP_
 
 #include "PCI.hpp"
-#include <lib/sync/Mutex.hpp>
+#include "BlockDevice.hpp"
+#include <kernel/ISR.hpp>
+#include <lib/sync/TicketLock.hpp>
 #include <lib/File.hpp>
 
 namespace kernel {
@@ -164,17 +166,63 @@ namespace kernel {
        *    <li> r: reserviert</li>
        * </ul>
        *
+       * @subsection busmaster Bus Master DMA
+       * Drives which report DMA support on a controller with a bus master
+       * base (BAR4) transfer by DMA. The buffer is described by a table of
+       * physical region descriptors (PRD), one page per channel. Every page
+       * of the buffer is translated to its frame, contiguous frames are
+       * merged into one region, and no region crosses a 64 KByte boundary.
+       * Buffers which are not word aligned fall back to PIO.
+       *
+       * @subsection atalarge Large Transfers
+       * A command moves up to 65536 sectors on drives with the 48 bit
+       * feature set and up to 256 on the others, at full 48 bit addresses.
+       * A request is split into as few commands as that allows, whatever
+       * its segments look like. A DMA command ends early where its PRD
+       * table is full, the next one continues there.
+       *
+       * @subsection atacache Write Cache
+       * Writes end when the drive took the data, they are not followed by
+       * a cache flush each. FLUSH CACHE (EXT) is sent for a flush request
+       * only, and behind the commands of a FUA request.
+       *
+       * @subsection atairq Interrupt Completion
+       * The drives raise IRQ 14 and 15, or the PCI interrupt line of a
+       * controller in native mode. start() only issues the first command of
+       * a chain and returns. The interrupt acknowledges the drive, moves the
+       * next sector of a PIO command or stops the bus master after a DMA
+       * command, issues the following command of the chain and at last ends
+       * it, so the submitter is free and readahead works as on AHCI. Before
+       * the first request started with interrupts on, e.g. while booting,
+       * the commands set nIEN and Drive::poll() steps them from
+       * BlockDevice::Request::wait() instead.
+       *
+       * The task file runs one command per channel, so a drive does not
+       * queue on its own: start() refuses a chain while the other drive of
+       * the channel has one in flight, the BlockDevice queue keeps it until
+       * the interrupt ended that one.
+       *
+       * @subsection atabenchmark CPU Benchmark
+       * kernel::Benchmark::cpu() reads 64 MByte sequentially and compares
+       * the cpu time charged to the reading thread with the elapsed time.
+       * With polling the reader burns the whole time, with interrupts only
+       * the setup and, for PIO, the copying of the sectors is left.
+       *
        * @note http://wiki.osdev.org/IDE
+       * @note http://wiki.osdev.org/ATA/ATAPI_using_DMA
        * @note http://www.ata-atapi.com/pata.html
        * @note http://www.lowlevel.eu/wiki/ATA
        *
        * @attention Keep in mind a Sector in LBA is 512 Byte in size!
        *
        * @since 13.04.2010
-       * @date 18.10.2011
+       * @date 19.10.2026
        * @author Arne Simon => email::[arne_simon@gmx.de]
        */
       class ATA: public lib::File {
+         public:
+            class Drive;
+
          protected:
 
             static const uint8 ATA_SR_BSY = 0x80;
@@ -250,6 +298,16 @@ namespace kernel {
             static const uint8 ATA_REG_CONTROL = 0x0C;
             static const uint8 ATA_REG_ALTSTATUS = 0x0C;
             static const uint8 ATA_REG_DEVADDRESS = 0x0D;
+            static const uint8 ATA_REG_BMCOMMAND = 0x0E; ///< Bus master command, bmide + 0.
+            static const uint8 ATA_REG_BMSTATUS = 0x10; ///< Bus master status, bmide + 2.
+            static const uint8 ATA_REG_BMPRDT = 0x12; ///< Physical address of the PRD table, bmide + 4, 32 bit.
+
+            // Bus Master Command and Status
+            static const uint8 ATA_BM_START = 0x01;
+            static const uint8 ATA_BM_READ = 0x08; ///< The device writes into the memory.
+            static const uint8 ATA_BM_ACTIVE = 0x01;
+            static const uint8 ATA_BM_ERR = 0x02;
+            static const uint8 ATA_BM_IRQ = 0x04;
 
             // Channels
             static const uint8 ATA_PRIMARY = 0x00;
@@ -259,55 +317,106 @@ namespace kernel {
             static const uint8 ATA_READ = 0x00;
             static const uint8 ATA_WRITE = 0x01;
 
+            /**
+             * A physical region descriptor of the bus master.
+             */
+            struct PRD {
+                  uint32 address; ///< Physical, word aligned.
+                  uint16 bytes; ///< 0 means 64 KByte.
+                  uint16 flags; ///< PRD_EOT marks the last entry.
+            };
+
+            static const uint16 PRD_EOT = 0x8000;
+            static const uint32 PRDCount = 512; ///< Entries in the one page table of a channel.
+            static const uint32 PRDBoundary = 0x10000; ///< A region may not cross 64 KByte.
+
+            static const uint32 MaxSectorsLBA28 = 256; ///< Sectors of one command.
+            static const uint32 MaxSectorsLBA48 = 65536;
+
+            // Phases of a channel
+            static const uint8 Idle = 0;
+            static const uint8 Transfer = 1; ///< A read or write command is in flight.
+            static const uint8 Flushing = 2; ///< FLUSH CACHE is in flight.
+
+            /**
+             * The interrupt routine of a channel.
+             */
+            class Interrupt: public ISR {
+               public:
+                  ATA* ata;
+                  uint8 channel;
+                  volatile uint32 completed; ///< Counts the claimed interrupts.
+
+                  /**
+                   * Acknowledges the drive and moves the command in flight on.
+                   */
+                  bool call();
+            } interrupts[ 2 ];
+
             struct ChannelRegisters {
                   uint16 base; ///< I/O Base.
                   uint16 ctrl; ///< Control Base
                   uint16 bmide; ///< Bus Master IDE
                   uint8 nIEN; ///< nIEN (No Interrupt);
+                  PRD* prdt; ///< The physical PRD table, or null without bus master.
+                  lib::sync::TicketLock lock; ///< Guards the command in flight, master and slave share the channel.
+                  uint8 phase; ///< Idle, Transfer or Flushing.
+                  Drive* drive; ///< The drive of the command in flight.
+                  BlockDevice::Request* request; ///< The chain in flight.
+                  BlockDevice::Cursor cursor; ///< Where the data of the command in flight goes.
+                  uint64 lba; ///< The first sector of the command in flight.
+                  uint32 left; ///< Sectors of the chain from lba on.
+                  uint32 sectors; ///< Sectors of the command in flight.
+                  uint32 moved; ///< Sectors of it moved by PIO.
+                  uint32 bytes; ///< Bytes the PRD table maps for it.
+                  bool dma; ///< The command in flight transfers by DMA.
             } channels[ 2 ];
 
+            bool interrupting; ///< A request was started with interrupts on, from then on the drives interrupt.
+
             uint8 *buf;
-            uint8 irq_invoked;
             uint8 atapi_packet[ 12 ];
 
             PCI::Device* _device;
 
             uint8 polling( uint8 channel, uint32 advanced_check );
 
+            /**
+             * Waits 400 nanoseconds, until the status shows the last command or sector.
+             */
+            void delay( uint8 channel );
+
+            /**
+             * Moves the command in flight on after the drive signalled: the
+             * next PIO sector, the next command of the chain, a flush for
+             * FUA, or the end of the chain. Runs in the interrupt, or in
+             * Drive::poll() while the drives run with nIEN.
+             *
+             * @param status The drive status, reading it acknowledged the drive.
+             * @param bmstatus The bus master status, 0 without bus master.
+             */
+            void step( uint8 channel, uint8 status, uint8 bmstatus );
+
             uint8 read( uint8 channel, uint8 reg );
 
             void write( uint8 channel, uint8 reg, uint8 data );
 
             void read_buffer( uchar channel, uchar reg, uint32 buffer, uint32 quads );
 
-            void initialize( uint32 BAR0, uint32 BAR1, uint32 BAR2, uint32 BAR3, uint32 BAR4 );
-
-         public:
             /**
-             * The Master Boot Record.
+             * Builds the PRD table of a buffer and loads the bus master.
+             *
+             * @return False if the buffer can not be transferred by DMA.
              */
-            struct MBR {
-                  uint8 bootstrap[ 436 ];
-                  uint8 disk_id[ 10 ];
-                  struct {
-                        uint8 indicator; ///< 0 = not bootable, 0x80 = bootable
-                        uint8 start_head;
-                        uint16 start_sector_cylinder;
-                        uint8 id;
-                        uint8 end_head;
-                        uint16 end_sector_cylinder;
-                        uint32 sector; ///< The LBA starting sector.
-                        uint32 size; ///< Sectors in partition.
-                  } partition[ 4 ];
-                  uint8 validation[ 2 ]; ///< should be { 0x55, 0xAA }
-
-                  bool isValid();
-            }__attribute__((packed));
+            bool prepare( uint8 channel, uint8 direction, BlockDevice::Cursor cursor, uint32& bytes );
 
+            void initialize( uint32 BAR0, uint32 BAR1, uint32 BAR2, uint32 BAR3, uint32 BAR4 );
+
+         public:
             /**
              * An ide drive.
              */
-            class Drive {
+            class Drive: public BlockDevice {
                   friend class ATA;
                public:
                   ATA* ata; ///< The ATA controller
@@ -318,26 +427,51 @@ namespace kernel {
                   uint16 signature; ///< Drive signature.
                   uint16 capabilities; ///< Features.
                   uint32 commandSets; ///< Command sets supported.
-                  uint32 size; ///< Size in sectors.
+                  bool dma; ///< The drive and its channel can do bus master DMA.
                   uchar model[ 41 ]; ///< Name of the model.
                   uint8 package[ 2 ];
 
                   uint8 print_error( uint8 err );
 
-                  uchar access( uint8 direction, uint32 lba, uint8 numsects, void* edi );
+                  /**
+                   * Issues the next command of the chain in flight on the
+                   * channel, with the channel held. It takes up to 256
+                   * sectors, with LBA48 up to 65536, fewer if the PRD table
+                   * can not map all of them. The first sector of a PIO
+                   * write goes along, the interrupt moves the rest.
+                   */
+                  void access();
 
-               public:
+                  /**
+                   * Moves one sector between the data port and the cursor.
+                   */
+                  void pio( uint8 direction, Cursor& cursor );
 
                   /**
-                   * Reads the master boot record from the drive.
+                   * Issues FLUSH CACHE, with the channel held.
                    */
-                  void read( MBR* mbr );
+                  void cacheFlush();
 
-                  void write( MBR* mbr );
+                  /**
+                   * @return True if the drive implements the 48 bit address feature set.
+                   */
+                  bool lba48() {
+                    return commandSets & ( 1 << 26 );
+                  }
 
-                  void readSector( uint8 numsects, uint32 lba, void* edi );
+                  /**
+                   * Issues the first command of the chain and returns, the
+                   * interrupt transfers it in as few commands as possible.
+                   *
+                   * @return False while the other drive of the channel has a chain in flight.
+                   */
+                  bool start( Request* r );
 
-                  void writeSector( uint8 numsects, uint32 lba, void* edi );
+                  /**
+                   * Steps the command in flight once the drive is ready, for
+                   * the commands issued with nIEN.
+                   */
+                  void poll();
             };
 
             Drive drives[ 4 ];
@@ -0,0 +1,397 @@
+/**
+ * BlockDevice.cpp
+ *
+ * @since 19.10.2026
+ * @author Arne Simon => email::[arne_simon@gmx.de]
+ */
+
+#include "BlockDevice.hpp"
+#include <kernel/driver/iosched/IOScheduler.hpp>
+#include <kernel/Thread.hpp>
+#include <kernel/System.hpp>
+#include <kernel/Futex.hpp>
+#include <lib/sync/Atomic.hpp>
+#include <lib/Exception.hpp>
+#include <lib/std.hpp>
+
+namespace kernel {
+
+  namespace driver {
+
+    BlockDevice::Request::Request()
+        : direction( Read ), error( 0 ), flags( 0 ), lba( 0 ), count( 0 ), segment_count( 0 ), callback( 0 ), data( 0 ),
+          done( 0 ), device( 0 ), next( 0 ), prev( 0 ), merged( 0 ), length( 0 ), pages( 0 ), owner( 0 ),
+          paged( false ), deadline( 0 ) {
+    }
+
+    void BlockDevice::Request::prepare( uint8 Direction, uint64 LBA, Callback Call, void* Data ) {
+      direction = Direction;
+      error = 0;
+      flags = 0;
+      lba = LBA;
+      count = 0;
+      segment_count = 0;
+      callback = Call;
+      data = Data;
+      done = 0;
+      next = 0;
+      prev = 0;
+      merged = 0;
+    }
+
+    bool BlockDevice::Request::add( void* address, uint32 bytes ) {
+      if ( segment_count == MaxSegments )
+        return false;
+
+      segments[ segment_count ].address = address;
+      segments[ segment_count ].bytes = bytes;
+      segment_count++;
+      count += bytes / SectorSize;
+
+      return true;
+    }
+
+    bool BlockDevice::Request::wait() {
+      if ( lib::interrupts() ) {
+        while ( not done )
+          Futex::wait( &done, 0 );
+      }
+      else {
+        // nobody takes the interrupt, e.g. while booting
+        while ( not done ) {
+          device->poll();
+          lib::sync::relax();
+        }
+      }
+
+      return error == 0;
+    }
+
+    BlockDevice::Cursor::Cursor( Request* r )
+        : request( r ), segment( 0 ), offset( 0 ) {
+    }
+
+    uint32 BlockDevice::Cursor::run( uint32& bytes ) {
+      if ( request == 0 ) {
+        bytes = 0;
+        return 0;
+      }
+
+      uint32 address = ( uint32 ) request->segments[ segment ].address + offset;
+
+      bytes = lib::min( request->segments[ segment ].bytes - offset, PhysicalMemory::PAGE_SIZE - ( address & 0xFFF ) );
+
+      if ( request->paged )
+        return request->owner->virtual_memory.getPhysicalAddress( address );
+
+      return address;
+    }
+
+    void BlockDevice::Cursor::advance( uint32 bytes ) {
+      while ( request && bytes ) {
+        uint32 step = lib::min( bytes, request->segments[ segment ].bytes - offset );
+
+        offset += step;
+        bytes -= step;
+
+        if ( offset < request->segments[ segment ].bytes )
+          continue;
+
+        // on to the next segment, or the first one of the next request
+        offset = 0;
+
+        if ( ++segment == request->segment_count ) {
+          segment = 0;
+          request = request->merged;
+        }
+      }
+    }
+
+    BlockDevice::Batch::Batch( BlockDevice* dev )
+        : device( dev ), count( 0 ) {
+    }
+
+    void BlockDevice::Batch::queue( uint8 direction, uint64 lba, uint32 sectors, void* buffer ) {
+      uint8* b = ( uint8* ) buffer;
+
+      while ( sectors ) {
+        uint32 n = device->fit( b, sectors );
+
+        if ( count == Size )
+          flush();
+
+        // hold the requests back until flush(), so they reach the scheduler together
+        if ( count == 0 )
+          device->plug();
+
+        Request& r = requests[ count++ ];
+
+        r.prepare( direction, lba );
+        r.add( b, n * SectorSize );
+
+        device->submit( &r );
+
+        b += n * SectorSize;
+        lba += n;
+        sectors -= n;
+      }
+    }
+
+    void BlockDevice::Batch::read( uint64 lba, uint32 sectors, void* buffer ) {
+      queue( Request::Read, lba, sectors, buffer );
+    }
+
+    void BlockDevice::Batch::write( uint64 lba, uint32 sectors, void* buffer ) {
+      queue( Request::Write, lba, sectors, buffer );
+    }
+
+    void BlockDevice::Batch::flush() {
+      if ( count == 0 )
+        return;
+
+      device->unplug();
+
+      bool ok = true;
+
+      for ( uint32 i = 0; i < count; ++i )
+        ok = requests[ i ].wait() && ok;
+
+      count = 0;
+
+      if ( not ok )
+        lib::Exception::throwing( "BlockDevice - batch failed!" );
+    }
+
+    BlockDevice::Batch::~Batch() {
+      flush();
+    }
+
+    BlockDevice::BlockDevice()
+        : size( 0 ), max_sectors( 1024 ), max_pages( 0xFFFFFFFF ), submitted( 0 ), completed( 0 ),
+          scheduler( IOScheduler::create() ), plugs( 0 ), kicks( 0 ), dispatching( 0 ) {
+      scheduler->attach( this );
+    }
+
+    BlockDevice::~BlockDevice() {
+      delete scheduler;
+    }
+
+    void BlockDevice::submit( Request* r ) {
+      Thread* t = Thread::current();
+
+      r->device = this;
+      r->done = 0;
+      r->next = 0;
+      r->prev = 0;
+      r->merged = 0;
+      r->length = r->count;
+      r->pages = 0;
+      r->owner = t ? t->process() : 0;
+      r->paged = t && System::isPaged(); // the kernel runs unpaged, a paged thread passes its own addresses
+
+      for ( uint32 i = 0; i < r->segment_count; ++i ) {
+        uint32 offset = ( uint32 ) r->segments[ i ].address & 0xFFF;
+
+        r->pages += ( offset + r->segments[ i ].bytes + 0xFFF ) >> 12;
+      }
+
+      lib::sync::fetch_add( &submitted, 1 );
+
+      // only a flush is empty, the driver takes nothing beyond its limits
+      bool valid = r->flags & Request::Flush ? r->count == 0 : r->count && r->lba + r->count <= size
+          && r->count <= max_sectors && r->pages <= max_pages;
+
+      if ( not valid ) {
+        end( r, 2 ); // seeking invalid position
+        return;
+      }
+
+      queue_lock.enter();
+      scheduler->add( r );
+      queue_lock.leave();
+
+      run();
+    }
+
+    void BlockDevice::run() {
+      lib::sync::fetch_add( &kicks, 1 );
+
+      // one dispatcher at a time, the others leave their kick for it
+      if ( lib::sync::exchange( &dispatching, 1 ) )
+        return;
+
+      uint32 seen;
+
+      do {
+        seen = kicks;
+        dispatch();
+        dispatching = 0;
+      } while ( kicks != seen && lib::sync::exchange( &dispatching, 1 ) == 0 );
+    }
+
+    void BlockDevice::dispatch() {
+      bool started = false;
+
+      while ( true ) {
+        queue_lock.enter();
+
+        Request* r = plugs ? 0 : scheduler->next();
+
+        queue_lock.leave();
+
+        if ( r == 0 )
+          break;
+
+        uint32 length = r->length; // the chain may be ended already when start() returns
+
+        if ( start( r ) ) {
+          started = true;
+
+          queue_lock.enter();
+          scheduler->started( length );
+          queue_lock.leave();
+
+          continue;
+        }
+
+        queue_lock.enter();
+        scheduler->requeue( r );
+        queue_lock.leave();
+
+        break;
+      }
+
+      if ( started )
+        kick();
+    }
+
+    void BlockDevice::end( Request* r, uint8 error ) {
+      while ( r ) {
+        // a waiter may drop the request as soon as it is done
+        Request* merged = r->merged;
+        Request::Callback callback = r->callback;
+
+        r->error = error;
+
+        lib::sync::fetch_add( &completed, 1 );
+
+        r->done = 1;
+        Futex::wake( &r->done, Futex::All );
+
+        if ( callback )
+          callback( r );
+
+        r = merged;
+      }
+
+      run();
+    }
+
+    void BlockDevice::plug() {
+      queue_lock.enter();
+      plugs++;
+      queue_lock.leave();
+    }
+
+    void BlockDevice::unplug() {
+      queue_lock.enter();
+      plugs--;
+      queue_lock.leave();
+
+      run();
+    }
+
+    void BlockDevice::elevator( IOScheduler* s ) {
+      queue_lock.enter();
+
+      IOScheduler* old = scheduler;
+
+      s->attach( this );
+
+      // the chains move over as they are, the new scheduler may merge them further
+      for ( Request* r = old->next(); r; r = old->next() ) {
+        r->next = 0;
+        r->prev = 0;
+        s->add( r );
+      }
+
+      scheduler = s;
+
+      queue_lock.leave();
+
+      delete old;
+    }
+
+    IOScheduler* BlockDevice::elevator() {
+      return scheduler;
+    }
+
+    uint32 BlockDevice::fit( void* address, uint32 sectors ) {
+      uint32 offset = ( uint32 ) address & 0xFFF;
+      uint32 n = lib::min( sectors, max_sectors );
+
+      // max_pages is small if it limits at all, the product does not overflow then
+      if ( ( ( offset + n * SectorSize + 0xFFF ) >> 12 ) > max_pages )
+        n = ( max_pages * 0x1000 - offset ) / SectorSize;
+
+      // a single sector beyond the limits fails in submit(), instead of never moving on
+      return lib::max( n, ( uint32 ) 1 );
+    }
+
+    void BlockDevice::readSector( uint32 numsects, uint64 lba, void* edi ) {
+      uint8* buffer = ( uint8* ) edi;
+
+      while ( numsects ) {
+        Request r;
+        uint32 n = fit( buffer, numsects );
+
+        r.prepare( Request::Read, lba );
+        r.add( buffer, n * SectorSize );
+
+        submit( &r );
+
+        if ( not r.wait() )
+          lib::Exception::throwing( "BlockDevice - read failed!" );
+
+        buffer += n * SectorSize;
+        lba += n;
+        numsects -= n;
+      }
+    }
+
+    void BlockDevice::writeSector( uint32 numsects, uint64 lba, void* edi ) {
+      uint8* buffer = ( uint8* ) edi;
+
+      while ( numsects ) {
+        Request r;
+        uint32 n = fit( buffer, numsects );
+
+        r.prepare( Request::Write, lba );
+        r.add( buffer, n * SectorSize );
+
+        submit( &r );
+
+        if ( not r.wait() )
+          lib::Exception::throwing( "BlockDevice - write failed!" );
+
+        buffer += n * SectorSize;
+        lba += n;
+        numsects -= n;
+      }
+    }
+
+    void BlockDevice::flush() {
+      Request r;
+
+      r.prepare( Request::Write, 0 );
+      r.flags = Request::Flush;
+
+      submit( &r );
+
+      if ( not r.wait() )
+        lib::Exception::throwing( "BlockDevice - flush failed!" );
+    }
+
+  }
+
+}
@@ -0,0 +1,371 @@
+/**
+ * BlockDevice.hpp
+ *
+ * @since 19.10.2026
+ * @author Arne Simon => email::[arne_simon@gmx.de]
+ */
+
+#ifndef KERNEL_DRIVER_BLOCKDEVICE_HPP_
+#define KERNEL_DRIVER_BLOCKDEVICE_HPP_
+
+#include <cpp.hpp>
+#include <lib/sync/TicketLock.hpp>
+
+namespace kernel {
+
+  class Process;
+
+  namespace driver {
+
+    class IOScheduler;
+
+    /**
+     * A drive addressed in sectors, whatever controller it hangs on.
+     *
+     * The file systems only know this interface, so they mount the same on
+     * an IDE drive, a SATA port, a virtio disk or a RAM disk.
+     *
+     * @section blockrequests Requests
+     * Every transfer is a Request: a sector range, the buffer as a list of
+     * segments and an optional callback. submit() hands it to the I/O
+     * scheduler of the device, run() passes the requests the scheduler
+     * picks to the driver with start() until the driver is full, the
+     * driver calls end() when a request is done.
+     * end() may run in interrupt context, the callback has to be as short
+     * as an ISR::call(). readSector() and writeSector() are a submit and a
+     * wait on top of it.
+     *
+     * @code
+     * BlockDevice::Request r[ 4 ];
+     *
+     * drive->plug(); // collect, nothing starts yet
+     *
+     * for ( uint32 i = 0; i < 4; ++i ) {
+     *   r[ i ].prepare( BlockDevice::Request::Read, lba + i * 8 );
+     *   r[ i ].add( buffer + i * 4096, 4096 );
+     *   drive->submit( &r[ i ] );
+     * }
+     *
+     * drive->unplug(); // all four go to the driver
+     *
+     * for ( uint32 i = 0; i < 4; ++i )
+     *   r[ i ].wait();
+     * @endcode
+     *
+     * @section blockplug Plugging
+     * While a device is plugged, submitted requests only queue up. The
+     * last unplug() starts them together, so a driver with a queue of its
+     * own (NCQ, virtqueues) gets a batch and notifies the device once in
+     * kick(). Meanwhile the scheduler merges adjacent requests.
+     *
+     * @section blockmerge Merging
+     * The scheduler chains a request to a queued one whose sectors it
+     * continues (back merge) or precedes (front merge). The driver gets
+     * the head of the chain and transfers all of its segments with one
+     * command, lba and length of the head describe the whole chain. The
+     * chain is limited by max_sectors and max_pages of the device.
+     *
+     * A single request has to keep to these limits, too, submit() fails
+     * one which does not. readSector(), writeSector() and Batch split
+     * their transfers with fit(), so any buffer size works through them.
+     *
+     * @section blockflush Write Cache
+     * A write ends when the drive has the data, which may be in its
+     * volatile cache only. flush() writes the cache back, a request with
+     * Request::Fua ends only when its data is on the medium. There are no
+     * barriers inside the queue: whoever needs an order waits for the
+     * writes before, then flushes, as the buffer cache does in sync().
+     * Flushes and FUA requests are never merged.
+     *
+     * @attention Keep in mind a Sector in LBA is 512 Byte in size!
+     *
+     * @since 19.10.2026
+     * @author Arne Simon => email::[arne_simon@gmx.de]
+     */
+    class BlockDevice {
+      public:
+        static const uint32 SectorSize = 512;
+
+        /**
+         * The Master Boot Record.
+         */
+        struct MBR {
+            uint8 bootstrap[ 436 ];
+            uint8 disk_id[ 10 ];
+            struct {
+                uint8 indicator; ///< 0 = not bootable, 0x80 = bootable
+                uint8 start_head;
+                uint16 start_sector_cylinder;
+                uint8 id;
+                uint8 end_head;
+                uint16 end_sector_cylinder;
+                uint32 sector; ///< The LBA starting sector.
+                uint32 size; ///< Sectors in partition.
+            } partition[ 4 ];
+            uint8 validation[ 2 ]; ///< should be { 0x55, 0xAA }
+
+            bool isValid() {
+              return validation[ 0 ] == 0x55 && validation[ 1 ] == 0xAA;
+            }
+        }__attribute__((packed));
+
+        /**
+         * A piece of the buffer of a request, in the address space of the submitter.
+         */
+        struct Segment {
+            void* address;
+            uint32 bytes; ///< A multiple of SectorSize.
+        };
+
+        /**
+         * A block I/O request.
+         */
+        class Request {
+          public:
+            static const uint8 Read = 0;
+            static const uint8 Write = 1;
+            static const uint32 MaxSegments = 16;
+
+            // Flags
+            static const uint8 Flush = 0x01; ///< An empty write, the drive writes its cache back.
+            static const uint8 Fua = 0x02; ///< The write ends when its data is on the medium.
+
+            typedef void (*Callback)( Request* r );
+
+            uint8 direction;
+            uint8 error; ///< 0, or the error code of the driver.
+            uint8 flags; ///< Flush or Fua, set after prepare().
+            uint64 lba; ///< 48 bit are used by the drives.
+            uint32 count; ///< Sectors, the sum of the segments.
+            Segment segments[ MaxSegments ];
+            uint32 segment_count;
+            Callback callback; ///< Called by end() after done is set, may be null.
+            void* data; ///< For the callback.
+            volatile uint32 done; ///< The futex of wait().
+            BlockDevice* device;
+            Request* next; ///< The queue of the scheduler.
+            Request* prev;
+            Request* merged; ///< The next request of the chain, in sector order.
+            uint32 length; ///< Sectors of the chain starting here.
+            uint32 pages; ///< Pages the segments of the chain starting here touch.
+            Process* owner; ///< The process of the submitter, null for the kernel.
+            bool paged; ///< The segments are virtual addresses of the owner, else physical ones.
+            uint64 deadline; ///< In TSC cycles, set by the scheduler.
+
+            Request();
+
+            /**
+             * Resets the request for a new transfer.
+             */
+            void prepare( uint8 direction, uint64 lba, Callback callback = 0, void* data = 0 );
+
+            /**
+             * Appends a segment to the buffer.
+             *
+             * @return False if there is no segment left.
+             */
+            bool add( void* address, uint32 bytes );
+
+            /**
+             * Waits until the request is done.
+             *
+             * @return True on success.
+             */
+            bool wait();
+        };
+
+        /**
+         * Walks the buffer of a chain as physical runs, so the drivers fill
+         * their PRD tables, descriptors or copies from one place.
+         *
+         * A run ends at a page end or at the end of a segment, the next
+         * frame may be elsewhere. Each request of the chain is translated
+         * with the page tables of its own submitter, not of the thread
+         * which happens to dispatch it. Neighbouring runs which happen to be
+         * contiguous are for the driver to join.
+         */
+        class Cursor {
+          protected:
+            Request* request;
+            uint32 segment;
+            uint32 offset; ///< Bytes into the segment.
+
+          public:
+            Cursor( Request* r = 0 );
+
+            /**
+             * @param bytes Set to the length of the run, 0 at the end of the chain.
+             * @return The physical address of the run at the cursor.
+             */
+            uint32 run( uint32& bytes );
+
+            /**
+             * Moves on, within the current segment or into the next ones.
+             */
+            void advance( uint32 bytes );
+        };
+
+        /**
+         * Collects reads and writes of a file system, so the scheduler
+         * can merge them, and waits for all of them together.
+         */
+        class Batch {
+          public:
+            static const uint32 Size = 32;
+
+          protected:
+            BlockDevice* device;
+            Request requests[ Size ];
+            uint32 count;
+
+            /**
+             * Queues a transfer in as many requests as fit() asks for.
+             */
+            void queue( uint8 direction, uint64 lba, uint32 sectors, void* buffer );
+
+          public:
+            Batch( BlockDevice* dev );
+
+            /**
+             * Queues a transfer, flushes first if the batch is full.
+             */
+            void read( uint64 lba, uint32 sectors, void* buffer );
+
+            void write( uint64 lba, uint32 sectors, void* buffer );
+
+            /**
+             * Starts the queued transfers and waits for them.
+             */
+            void flush();
+
+            ~Batch();
+        };
+
+        uint64 size; ///< Size in sectors.
+        uint32 max_sectors; ///< The longest chain the driver transfers at once.
+        uint32 max_pages; ///< The most pages of a chain the driver maps at once.
+        uint32 submitted; ///< Requests submitted.
+        uint32 completed; ///< Requests ended.
+
+      protected:
+        lib::sync::TicketLock queue_lock; ///< Guards the scheduler and the plugs, disables the interrupts itself.
+        IOScheduler* scheduler;
+        uint32 plugs;
+        volatile uint32 kicks; ///< Counts the calls of run().
+        volatile uint32 dispatching; ///< A run() hands requests to the driver.
+
+        /**
+         * Hands a request to the driver, without blocking in interrupt context.
+         *
+         * @return False if the driver is full, the request stays queued.
+         */
+        virtual bool start( Request* r ) = 0;
+
+        /**
+         * Finishes a request and the requests merged into it, called by the driver.
+         */
+        void end( Request* r, uint8 error );
+
+        /**
+         * Starts the queued requests while the device is not plugged.
+         *
+         * Only one caller dispatches, a run() meanwhile, e.g. by an end()
+         * inside start(), makes it look at the queue once more instead of
+         * recursing.
+         */
+        void run();
+
+        /**
+         * Hands queued requests to the driver until it is full.
+         */
+        void dispatch();
+
+        /**
+         * Tells the device about the requests start() queued, called once
+         * after a batch. A driver with a doorbell rings it here.
+         */
+        virtual void kick() {
+        }
+
+        /**
+         * Completes the finished requests without the interrupt, e.g. while booting.
+         */
+        virtual void poll() {
+        }
+
+      public:
+        BlockDevice();
+
+        /**
+         * Queues the request and starts it unless the device is plugged.
+         *
+         * A request longer than max_sectors or touching more than
+         * max_pages pages ends with an error at once.
+         */
+        void submit( Request* r );
+
+        /**
+         * How much of a transfer one request may take.
+         *
+         * @param address The buffer of the transfer.
+         * @param sectors The length of the transfer.
+         * @return The sectors from the start of the buffer which keep to max_sectors and max_pages.
+         */
+        uint32 fit( void* address, uint32 sectors );
+
+        /**
+         * Holds submitted requests back, nests.
+         */
+        void plug();
+
+        /**
+         * Starts the held back requests with the last unplug.
+         */
+        void unplug();
+
+        /**
+         * Switches the I/O scheduler, the queued requests move over.
+         *
+         * @param s Created with new, owned by the device from now on.
+         */
+        void elevator( IOScheduler* s );
+
+        /**
+         * @return The current I/O scheduler, for its counters.
+         */
+        IOScheduler* elevator();
+
+        /**
+         * Reads synchronously, one request after the other as fit() splits the buffer.
+         */
+        void readSector( uint32 numsects, uint64 lba, void* edi );
+
+        /**
+         * Writes synchronously, one request after the other as fit() splits the buffer.
+         */
+        void writeSector( uint32 numsects, uint64 lba, void* edi );
+
+        /**
+         * Writes the volatile cache of the drive back and waits for it.
+         */
+        void flush();
+
+        /**
+         * Reads the master boot record from the drive.
+         */
+        void read( MBR* mbr ) {
+          readSector( 1, 0, mbr );
+        }
+
+        void write( MBR* mbr ) {
+          writeSector( 1, 0, mbr );
+        }
+
+        virtual ~BlockDevice();
+    };
+
+  }
+
+}
+
+#endif /* KERNEL_DRIVER_BLOCKDEVICE_HPP_ */
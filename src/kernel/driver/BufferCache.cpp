@@ -0,0 +1,559 @@
+/**
+ * BufferCache.cpp
+ *
+ * @since 19.10.2026
+ * @author Arne Simon => email::[arne_simon@gmx.de]
+ */
+
+#include "BufferCache.hpp"
+#include <kernel/System.hpp>
+#include <kernel/Thread.hpp>
+#include <kernel/Futex.hpp>
+#include <lib/sync/Atomic.hpp>
+#include <lib/Exception.hpp>
+#include <lib/std.hpp>
+
+namespace kernel {
+
+  namespace driver {
+
+    BufferCache* BufferCache::cache = 0;
+
+    BufferCache::List::List()
+        : head( 0 ), tail( 0 ), count( 0 ) {
+    }
+
+    void BufferCache::List::push( Buffer* b ) {
+      b->prev = 0;
+      b->next = head;
+
+      if ( head )
+        head->prev = b;
+      else
+        tail = b;
+
+      head = b;
+      count++;
+    }
+
+    void BufferCache::List::remove( Buffer* b ) {
+      if ( b->prev )
+        b->prev->next = b->next;
+      else
+        head = b->next;
+
+      if ( b->next )
+        b->next->prev = b->prev;
+      else
+        tail = b->prev;
+
+      b->next = 0;
+      b->prev = 0;
+      count--;
+    }
+
+    BufferCache::Readahead::Readahead()
+        : next( 0 ), ahead( 0 ), window( MinWindow ) {
+    }
+
+    BufferCache::BufferCache( uint32 pages )
+        : hits( 0 ), misses( 0 ), evictions( 0 ), writebacks( 0 ), prefetched( 0 ), dirty( 0 ), released( 0 ), capacity( pages ), ghost_next( 0 ),
+          starving( 0 ) {
+      buffers = new Buffer[ capacity ];
+      ghosts = new Ghost[ capacity / 2 ];
+
+      lib::memset( table, 0, sizeof(table) );
+      lib::memset( ghost_table, 0, sizeof(ghost_table) );
+      lib::memset( ghosts, 0, capacity / 2 * sizeof(Ghost) );
+
+      for ( uint32 i = 0; i < capacity; ++i ) {
+        Buffer* b = &buffers[ i ];
+
+        b->device = 0;
+        b->block = 0;
+        b->data = ( uint8* ) System::physical_memory.alloc();
+        b->flags = 0;
+        b->list = Free;
+        b->locked = 0;
+        b->refs = 0;
+        b->hash = 0;
+
+        lists[ Free ].push( b );
+      }
+
+      cache = this;
+
+      new Thread( system, ( uint32 ) &BufferCache::flusher, Thread::DefaultStackSize );
+    }
+
+    BufferCache* BufferCache::instance() {
+      if ( cache == 0 )
+        new BufferCache( DefaultCapacity );
+
+      return cache;
+    }
+
+    uint32 BufferCache::bucket( BlockDevice* device, uint64 block ) {
+      return ( ( uint32 ) device >> 4 ^ ( uint32 ) ( block / BlockSectors ) ) & ( Buckets - 1 );
+    }
+
+    bool BufferCache::ghost( BlockDevice* device, uint64 block ) {
+      for ( Ghost* g = ghost_table[ bucket( device, block ) ]; g; g = g->hash ) {
+        if ( g->device == device && g->block == block ) {
+          forget( g );
+          return true;
+        }
+      }
+
+      return false;
+    }
+
+    void BufferCache::forget( Ghost* g ) {
+      if ( g->device == 0 )
+        return;
+
+      Ghost** i = &ghost_table[ bucket( g->device, g->block ) ];
+
+      while ( *i != g )
+        i = &( *i )->hash;
+
+      *i = g->hash;
+      g->device = 0;
+    }
+
+    BufferCache::Buffer* BufferCache::reclaim() {
+      Buffer* b = lists[ Free ].tail;
+
+      if ( b ) {
+        lists[ Free ].remove( b );
+        return b;
+      }
+
+      // A1in gives a page while it holds more than its share, else the least recently used one of Am
+      uint8 first = lists[ In ].count > capacity / 4 ? In : Main;
+      uint8 order[ 2 ] = { first, first == In ? Main : In };
+
+      for ( uint32 k = 0; k < 2; ++k ) {
+        List& l = lists[ order[ k ] ];
+
+        for ( b = l.tail; b; b = b->prev ) {
+          if ( b->refs || b->locked || ( b->flags & Dirty ) )
+            continue;
+
+          l.remove( b );
+
+          Buffer** i = &table[ bucket( b->device, b->block ) ];
+
+          while ( *i != b )
+            i = &( *i )->hash;
+
+          *i = b->hash;
+
+          if ( b->list == In && capacity / 2 ) {
+            Ghost* g = &ghosts[ ghost_next ];
+            uint32 h = bucket( b->device, b->block );
+
+            // the oldest address leaves A1out
+            forget( g );
+
+            g->device = b->device;
+            g->block = b->block;
+            g->hash = ghost_table[ h ];
+            ghost_table[ h ] = g;
+
+            ghost_next = ( ghost_next + 1 ) % ( capacity / 2 );
+          }
+
+          evictions++;
+
+          return b;
+        }
+      }
+
+      return 0;
+    }
+
+    BufferCache::Buffer* BufferCache::get( BlockDevice* device, uint64 block, bool wait ) {
+      uint32 h = bucket( device, block );
+
+      while ( true ) {
+        // a page put back from here on wakes us up below
+        uint32 seen = released;
+
+        lock.enter();
+
+        for ( Buffer* b = table[ h ]; b; b = b->hash ) {
+          if ( b->device != device || b->block != block )
+            continue;
+
+          hits++;
+
+          if ( b->list == Main ) {
+            lists[ Main ].remove( b );
+            lists[ Main ].push( b );
+          }
+
+          b->refs++;
+
+          lock.leave();
+
+          return b;
+        }
+
+        Buffer* b = reclaim();
+
+        if ( b ) {
+          misses++;
+
+          b->device = device;
+          b->block = block;
+          b->flags = 0;
+          b->refs = 1;
+
+          // a page missed again soon after it left A1in is hot
+          b->list = ghost( device, block ) ? Main : In;
+          lists[ b->list ].push( b );
+
+          b->hash = table[ h ];
+          table[ h ] = b;
+
+          lock.leave();
+
+          return b;
+        }
+
+        lock.leave();
+
+        if ( not wait )
+          return 0;
+
+        // every page is dirty or held, the dirty ones are clean after a sync,
+        // the held ones come back with put()
+        if ( dirty ) {
+          sync();
+          continue;
+        }
+
+        lib::sync::fetch_add( &starving, 1 );
+        Futex::wait( &released, seen );
+        lib::sync::fetch_add( &starving, ( uint32 ) -1 );
+      }
+    }
+
+    void BufferCache::put( Buffer* b ) {
+      if ( lib::sync::fetch_add( &b->refs, ( uint32 ) -1 ) != 1 )
+        return;
+
+      // counted before starving is read, so a get() going to sleep sees either
+      lib::sync::fetch_add( &released, 1 );
+
+      if ( starving )
+        Futex::wake( &released, Futex::All );
+    }
+
+    void BufferCache::enter( Buffer* b ) {
+      while ( lib::sync::exchange( &b->locked, 1 ) )
+        Futex::wait( &b->locked, 1 );
+    }
+
+    void BufferCache::leave( Buffer* b ) {
+      b->locked = 0;
+      Futex::wake( &b->locked, Futex::All );
+    }
+
+    uint32 BufferCache::sectors( Buffer* b ) {
+      uint64 left = b->device->size - b->block;
+
+      return left < BlockSectors ? ( uint32 ) left : BlockSectors;
+    }
+
+    void BufferCache::fill( Buffer* b ) {
+      b->device->readSector( sectors( b ), b->block, b->data );
+      b->flags |= Valid;
+    }
+
+    void BufferCache::filled( BlockDevice::Request* r ) {
+      Buffer* b = ( Buffer* ) r->data;
+
+      // on an error the page stays invalid, the reader tries again itself
+      if ( r->error == 0 )
+        b->flags |= Valid;
+
+      cache->leave( b );
+      cache->put( b );
+    }
+
+    void BufferCache::prefetch( BlockDevice* device, uint64 lba, uint32 count ) {
+      uint64 end = lib::min( lba + count, device->size );
+
+      device->plug();
+
+      for ( uint64 block = lba & ~( uint64 ) ( BlockSectors - 1 ); block < end; block += BlockSectors ) {
+        Buffer* b = get( device, block, false );
+
+        // no room without writing back, the reader is faster than a write-back anyway
+        if ( b == 0 )
+          break;
+
+        // cached already, or someone reads or writes it right now
+        if ( ( b->flags & Valid ) || lib::sync::exchange( &b->locked, 1 ) ) {
+          put( b );
+          continue;
+        }
+
+        if ( b->flags & Valid ) {
+          leave( b );
+          put( b );
+          continue;
+        }
+
+        b->request.prepare( BlockDevice::Request::Read, block, &BufferCache::filled, b );
+        b->request.add( b->data, sectors( b ) * BlockDevice::SectorSize );
+
+        prefetched++;
+
+        // the page lock and the reference go with the request to filled()
+        device->submit( &b->request );
+      }
+
+      device->unplug();
+    }
+
+    void BufferCache::advise( BlockDevice* device, uint64 lba, uint32 count, Readahead* ra ) {
+      uint64 end = lba + count;
+
+      // a small gap, like an indirect block between the data blocks of a file, is still sequential
+      if ( lba < ra->next || lba > ra->next + BlockSectors ) {
+        ra->window = MinWindow;
+        ra->ahead = end;
+      }
+
+      ra->next = end;
+
+      // without interrupts nobody would complete the prefetched pages
+      if ( not lib::interrupts() )
+        return;
+
+      if ( end + ra->window / 2 < ra->ahead )
+        return;
+
+      uint64 from = lib::max( ra->ahead, end );
+
+      prefetch( device, from, ra->window );
+
+      ra->ahead = from + ra->window;
+      ra->window = lib::min( ra->window * 2, MaxWindow );
+    }
+
+    void BufferCache::read( BlockDevice* device, uint64 lba, uint32 count, void* buffer, Readahead* ra ) {
+      uint8* out = ( uint8* ) buffer;
+
+      if ( lba + count > device->size )
+        lib::Exception::throwing( "seeking invalid position!" );
+
+      if ( ra )
+        advise( device, lba, count, ra );
+
+      while ( count ) {
+        uint64 block = lba & ~( uint64 ) ( BlockSectors - 1 );
+        uint32 offset = ( uint32 ) ( lba - block );
+        uint32 n = lib::min( count, BlockSectors - offset );
+        Buffer* b = get( device, block );
+
+        enter( b );
+
+        if ( not ( b->flags & Valid ) )
+          fill( b );
+
+        lib::memcpy( out, b->data + offset * BlockDevice::SectorSize, n * BlockDevice::SectorSize );
+
+        leave( b );
+        put( b );
+
+        lba += n;
+        count -= n;
+        out += n * BlockDevice::SectorSize;
+      }
+    }
+
+    void BufferCache::write( BlockDevice* device, uint64 lba, uint32 count, void* buffer ) {
+      uint8* in = ( uint8* ) buffer;
+
+      if ( lba + count > device->size )
+        lib::Exception::throwing( "seeking invalid position!" );
+
+      while ( count ) {
+        uint64 block = lba & ~( uint64 ) ( BlockSectors - 1 );
+        uint32 offset = ( uint32 ) ( lba - block );
+        uint32 n = lib::min( count, BlockSectors - offset );
+        Buffer* b = get( device, block );
+
+        enter( b );
+
+        // a page written as a whole needs no read
+        if ( not ( b->flags & Valid ) && n < sectors( b ) )
+          fill( b );
+
+        lib::memcpy( b->data + offset * BlockDevice::SectorSize, in, n * BlockDevice::SectorSize );
+
+        b->flags |= Valid;
+
+        if ( not ( b->flags & Dirty ) ) {
+          b->flags |= Dirty;
+
+          if ( lib::sync::fetch_add( &dirty, 1 ) == 0 )
+            Futex::wake( &dirty, 1 );
+        }
+
+        leave( b );
+        put( b );
+
+        lba += n;
+        count -= n;
+        in += n * BlockDevice::SectorSize;
+      }
+
+      // throttle a writer which outruns the flusher
+      if ( dirty > capacity / 2 )
+        sync( device );
+    }
+
+    void BufferCache::sync( BlockDevice* device ) {
+      if ( device == 0 ) {
+        // one device after the other, each one gets its own batches
+        while ( true ) {
+          lock.enter();
+
+          for ( uint32 i = 0; i < capacity && device == 0; ++i ) {
+            if ( buffers[ i ].flags & Dirty )
+              device = buffers[ i ].device;
+          }
+
+          lock.leave();
+
+          if ( device == 0 )
+            return;
+
+          sync( device );
+          device = 0;
+        }
+      }
+
+      Buffer* pages[ BlockDevice::Batch::Size ];
+      BlockDevice::Batch* batch = new BlockDevice::Batch( device );
+      uint32 i = 0;
+      uint32 written = 0;
+
+      while ( i < capacity ) {
+        uint32 n = 0;
+
+        lock.enter();
+
+        // a held page is not evicted, so it keeps its address until we look at it
+        for ( ; i < capacity && n < BlockDevice::Batch::Size; ++i ) {
+          Buffer* b = &buffers[ i ];
+
+          if ( b->device == device && ( b->flags & Dirty ) ) {
+            b->refs++;
+            pages[ n++ ] = b;
+          }
+        }
+
+        lock.leave();
+
+        for ( uint32 k = 0; k < n; ++k ) {
+          enter( pages[ k ] );
+
+          if ( pages[ k ]->flags & Dirty ) {
+            batch->write( pages[ k ]->block, sectors( pages[ k ] ), pages[ k ]->data );
+            written++;
+          }
+        }
+
+        batch->flush();
+
+        for ( uint32 k = 0; k < n; ++k ) {
+          Buffer* b = pages[ k ];
+
+          if ( b->flags & Dirty ) {
+            b->flags &= ~Dirty;
+            lib::sync::fetch_add( &dirty, ( uint32 ) -1 );
+            writebacks++;
+          }
+
+          leave( b );
+          put( b );
+        }
+      }
+
+      delete batch;
+
+      // the batch waited for the writes, now they only have to leave the drive cache
+      if ( written )
+        device->flush();
+    }
+
+    void BufferCache::invalidate( BlockDevice* device ) {
+      sync( device );
+
+      lock.enter();
+
+      for ( uint32 i = 0; i < capacity; ++i ) {
+        Buffer* b = &buffers[ i ];
+
+        if ( b->device != device || b->refs || b->list == Free )
+          continue;
+
+        lists[ b->list ].remove( b );
+
+        Buffer** h = &table[ bucket( b->device, b->block ) ];
+
+        while ( *h != b )
+          h = &( *h )->hash;
+
+        *h = b->hash;
+
+        b->device = 0;
+        b->flags = 0;
+        b->list = Free;
+
+        lists[ Free ].push( b );
+      }
+
+      lock.leave();
+    }
+
+    void* BufferCache::flusher() {
+      BufferCache* c = cache;
+
+      while ( true ) {
+        if ( c->dirty == 0 ) {
+          Futex::wait( &c->dirty, 0 );
+          continue;
+        }
+
+        // let more pages get dirty, so they go out in one batch
+        Thread::sleep( FlushDelay * 1000 );
+
+        c->sync();
+      }
+
+      return 0;
+    }
+
+    BufferCache::~BufferCache() {
+      sync();
+
+      for ( uint32 i = 0; i < capacity; ++i )
+        System::physical_memory.free( buffers[ i ].data );
+
+      delete[] buffers;
+      delete[] ghosts;
+
+      if ( cache == this )
+        cache = 0;
+    }
+
+  }
+
+}
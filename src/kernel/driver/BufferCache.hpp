@@ -0,0 +1,288 @@
+/**
+ * BufferCache.hpp
+ *
+ * @since 19.10.2026
+ * @author Arne Simon => email::[arne_simon@gmx.de]
+ */
+
+#ifndef KERNEL_DRIVER_BUFFERCACHE_HPP_
+#define KERNEL_DRIVER_BUFFERCACHE_HPP_
+
+#include <cpp.hpp>
+#include <kernel/driver/BlockDevice.hpp>
+#include <lib/sync/Mutex.hpp>
+
+namespace kernel {
+
+  namespace driver {
+
+    /**
+     * The block cache shared by all file systems and block devices.
+     *
+     * The cache holds pages of BlockSectors sectors, indexed by device and
+     * first sector in a hash table. read() and write() copy between a
+     * caller's buffer and the pages, reading the missing pages from the
+     * device. Writes only mark a page dirty, the flusher thread writes the
+     * dirty pages back FlushDelay after the first one got dirty, sync()
+     * writes them back at once. Dirty pages go out through a
+     * BlockDevice::Batch, so the scheduler merges neighbours. A write-back
+     * waits for its writes and then flushes the drive cache once, which
+     * makes it the commit point of the file systems on top.
+     *
+     * @section cache2q 2Q Replacement
+     * A page read for the first time goes to the FIFO A1in. If it is
+     * referenced again while there, it stays where it is. When it leaves
+     * A1in, its address is remembered in the ghost list A1out. A page
+     * missed while its address is in A1out has been used twice within a
+     * short time and goes to the LRU list Am. A1in is kept at a quarter of
+     * the pages, A1out remembers half as many addresses as there are pages.
+     * So a single scan over a large file only cycles through A1in and does
+     * not push the hot metadata out of Am.
+     *
+     * Only clean pages nobody holds are evicted. If there are none, the
+     * caller writes the dirty ones back first, or sleeps until a holder
+     * puts a page back. A writer which finds more than half of the pages
+     * dirty writes them back as well.
+     *
+     * @section cachelocks Locking
+     * A mutex guards the hash table and the lists, the data of a page is
+     * guarded by its own lock, a futex word. Device I/O happens with only
+     * the page locks held, a thread touching a page which is being read
+     * sleeps on its lock.
+     *
+     * @section cachereadahead Readahead
+     * A reader passing a Readahead state to read() gets the following
+     * sectors prefetched while it copies. As long as its reads continue
+     * each other, up to a gap of a page, the window starts at MinWindow
+     * and doubles with every prefetch up to MaxWindow; the next prefetch
+     * starts as soon as the reader reaches the sectors of the last one, so
+     * the device never runs dry. A read elsewhere shrinks the window to
+     * MinWindow again. Prefetched pages are locked and held until their
+     * read completes, the pages of a window are submitted with the device
+     * plugged, so the scheduler merges them into commands as large as the
+     * driver takes. Pages read ahead for nothing are only in A1in and go
+     * first. The drivers complete the pages from their interrupts, so the
+     * reader copies while the device reads.
+     *
+     * @code
+     * kernel::driver::BufferCache* cache = kernel::driver::BufferCache::instance();
+     * uint8 sector[ 512 ];
+     *
+     * cache->read( drive, 2, 1, sector ); // from the disk
+     * cache->read( drive, 2, 1, sector ); // from memory
+     * sector[ 0 ] = 1;
+     * cache->write( drive, 2, 1, sector ); // dirty, written back by the flusher
+     * cache->sync( drive );
+     *
+     * system->video << "hits " << cache->hits << " misses " << cache->misses << "\n";
+     * @endcode
+     *
+     * Reading a file of a few MByte shows the streaming rate with readahead:
+     * @code
+     * kernel::driver::Ext2::File* f = ( kernel::driver::Ext2::File* ) fs->root->get( "kernel.elf" );
+     * void* data;
+     * uint32 size;
+     * uint64 start = lib::rdtsc();
+     *
+     * f->read( &data, &size );
+     *
+     * uint32 ms = ( uint32 ) ( ( lib::rdtsc() - start ) / system->shared->tsc_khz ) + 1;
+     *
+     * system->video << size / ms << " KByte/s, " << cache->prefetched << " pages read ahead\n";
+     * @endcode
+     *
+     * @note Theodore Johnson, Dennis Shasha: 2Q: A Low Overhead High Performance Buffer Management Replacement Algorithm, VLDB 1994
+     *
+     * @since 19.10.2026
+     * @author Arne Simon => email::[arne_simon@gmx.de]
+     */
+    class BufferCache {
+      public:
+        static const uint32 BlockSectors = 8;
+        static const uint32 BlockSize = BlockSectors * BlockDevice::SectorSize;
+        static const uint32 DefaultCapacity = 1024; ///< Pages, 4 MByte.
+        static const uint32 Buckets = 1024; ///< A power of two.
+        static const uint32 FlushDelay = 5000; ///< Milliseconds a dirty page waits for the flusher.
+        static const uint32 MinWindow = 32; ///< Sectors, 16 KByte.
+        static const uint32 MaxWindow = 2048; ///< Sectors, 1 MByte.
+
+        // Page flags
+        static const uint8 Valid = 0x01;
+        static const uint8 Dirty = 0x02;
+
+        // Lists
+        static const uint8 Free = 0;
+        static const uint8 In = 1; ///< A1in
+        static const uint8 Main = 2; ///< Am
+
+        /**
+         * A cached page.
+         */
+        struct Buffer {
+            BlockDevice* device;
+            uint64 block; ///< The first sector, a multiple of BlockSectors.
+            uint8* data; ///< BlockSize bytes, physical.
+            uint8 flags; ///< Valid, Dirty, guarded by the page lock.
+            uint8 list;
+            volatile uint32 locked; ///< The page lock, a futex word.
+            volatile uint32 refs; ///< Holders, a held page is not evicted.
+            Buffer* hash;
+            Buffer* next;
+            Buffer* prev;
+            BlockDevice::Request request; ///< Reads the page ahead.
+        };
+
+        /**
+         * The readahead state of a reader, e.g. an open file.
+         */
+        struct Readahead {
+            uint64 next; ///< The sector a sequential read continues at.
+            uint64 ahead; ///< The end of the last prefetch.
+            uint32 window; ///< Sectors of the next prefetch.
+
+            Readahead();
+        };
+
+        uint32 hits;
+        uint32 misses;
+        uint32 evictions;
+        uint32 writebacks; ///< Pages written back.
+        uint32 prefetched; ///< Pages read ahead.
+        volatile uint32 dirty; ///< Dirty pages, the futex word of the flusher.
+        volatile uint32 released; ///< Pages their last holder put back, the futex word of a starving get().
+
+      protected:
+        /**
+         * A list of pages, the head is the newest.
+         */
+        struct List {
+            Buffer* head;
+            Buffer* tail;
+            uint32 count;
+
+            List();
+
+            void push( Buffer* b );
+
+            void remove( Buffer* b );
+        };
+
+        /**
+         * An address remembered in A1out.
+         */
+        struct Ghost {
+            BlockDevice* device; ///< Null for a free entry.
+            uint64 block;
+            Ghost* hash;
+        };
+
+        static BufferCache* cache;
+
+        lib::sync::Mutex lock; ///< Guards the hash table, the lists and the ghosts.
+        uint32 capacity;
+        Buffer* buffers;
+        Buffer* table[ Buckets ];
+        List lists[ 3 ]; ///< Free, A1in and Am.
+        Ghost* ghosts; ///< A ring of capacity / 2 addresses.
+        Ghost* ghost_table[ Buckets ]; ///< The ghosts by address.
+        uint32 ghost_next;
+        volatile uint32 starving; ///< Callers of get() waiting for a page.
+
+        uint32 bucket( BlockDevice* device, uint64 block );
+
+        /**
+         * @return True if the address is in A1out, which forgets it.
+         */
+        bool ghost( BlockDevice* device, uint64 block );
+
+        /**
+         * Takes a ghost out of its hash chain, if it holds an address.
+         */
+        void forget( Ghost* g );
+
+        /**
+         * @return A clean page nobody holds, taken off its list and the hash table, or null.
+         */
+        Buffer* reclaim();
+
+        /**
+         * Looks a page up or makes room for it, held by the caller.
+         *
+         * @param wait Writes dirty pages back or sleeps until a page is put
+         *             back if there is no room, else returns null.
+         */
+        Buffer* get( BlockDevice* device, uint64 block, bool wait = true );
+
+        void put( Buffer* b );
+
+        void enter( Buffer* b );
+
+        void leave( Buffer* b );
+
+        /**
+         * Reads a page locked by the caller.
+         */
+        void fill( Buffer* b );
+
+        /**
+         * @return The sectors of the page within its device.
+         */
+        uint32 sectors( Buffer* b );
+
+        /**
+         * Starts reading the missing pages of a range, without waiting.
+         */
+        void prefetch( BlockDevice* device, uint64 lba, uint32 count );
+
+        /**
+         * Updates the readahead state for a read and prefetches if it is time to.
+         */
+        void advise( BlockDevice* device, uint64 lba, uint32 count, Readahead* ra );
+
+        /**
+         * Completes a prefetched page, called by BlockDevice::end().
+         */
+        static void filled( BlockDevice::Request* r );
+
+        /**
+         * The main loop of the flusher thread.
+         */
+        static void* flusher();
+
+      public:
+        /**
+         * @param pages The capacity in pages.
+         */
+        BufferCache( uint32 pages );
+
+        /**
+         * @return The cache, created with DefaultCapacity on the first call.
+         */
+        static BufferCache* instance();
+
+        /**
+         * @param ra The readahead state of the reader, null for none.
+         */
+        void read( BlockDevice* device, uint64 lba, uint32 count, void* buffer, Readahead* ra = 0 );
+
+        void write( BlockDevice* device, uint64 lba, uint32 count, void* buffer );
+
+        /**
+         * Writes the dirty pages of a device back, of all devices for null,
+         * and flushes the drive caches.
+         */
+        void sync( BlockDevice* device = 0 );
+
+        /**
+         * Writes back and forgets the pages of a device, e.g. before it goes away.
+         */
+        void invalidate( BlockDevice* device );
+
+        ~BufferCache();
+    };
+
+  }
+
+}
+
+#endif /* KERNEL_DRIVER_BUFFERCACHE_HPP_ */
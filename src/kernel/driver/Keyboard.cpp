@@ -68,12 +68,17 @@ namespace kernel {
     }
 
     bool Keyboard::call() {
-      int scancode = 0;
+      // reading the scancode acknowledges the controller
+      system->defer( this, lib::inb( 0x60 ), WorkQueue::High );
+
+      return true;
+    }
+
+    void Keyboard::work( uint32 data ) {
+      int scancode = data;
       int keycode = 0;
       int break_code = 0;
 
-      scancode = lib::inb( 0x60 );
-
       // Um einen Breakcode handelt es sich, wenn das oberste Bit gesetzt ist und
       // es kein e0 oder e1 fuer einen Extended-scancode ist
       if ( ( scancode & 0x80 ) != 0 and ( e1_code != 0 or scancode != 0xE1 )
@@ -144,8 +149,6 @@ namespace kernel {
 
         holded[ keycode ] = !break_code;
       }
-
-      return true;
     }
 
   }
@@ -49,8 +49,16 @@ namespace kernel {
 
         lib::collection::Array< EventListener* > listeners;
 
+        /**
+         * Fetches the scancode and defers it.
+         */
         bool call();
 
+        /**
+         * Translates the scancode and informs the listeners.
+         */
+        void work( uint32 scancode );
+
         virtual ~Keyboard() {
         }
     };
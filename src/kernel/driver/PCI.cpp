@@ -44,6 +44,13 @@ namespace kernel {
 
     }
 
+    void PCI::ConfigBlock::write( uint32 bus, uint32 device, uint32 func, uint8 offset ) {
+      uint32 address = ( bus << 16 ) | ( device << 11 ) | ( func << 8 ) | offset << 2 | ( ( uint32 ) 0x80000000 );
+
+      lib::out( config_address, address );
+      lib::out( config_data, data[ offset ] );
+    }
+
     bool PCI::ConfigBlock::isValid( uint32 bus, uint32 device, uint32 func ) {
       uint32 address;
       uint32 tmp = 0;
@@ -63,6 +70,48 @@ namespace kernel {
       config.read( bus, device, func );
     }
 
+    void PCI::Device::enable( uint16 flags ) {
+      config.command |= flags;
+      config.status = 0; // the status bits are cleared by writing ones
+
+      config.write( bus, device, func, 1 );
+    }
+
+    uint32 PCI::Device::read( uint8 offset ) {
+      uint32 address = ( bus << 16 ) | ( device << 11 ) | ( func << 8 ) | ( offset & 0xFC ) | ( ( uint32 ) 0x80000000 );
+
+      lib::out( config_address, address );
+
+      return lib::in( config_data );
+    }
+
+    void PCI::Device::write( uint8 offset, uint32 value ) {
+      uint32 address = ( bus << 16 ) | ( device << 11 ) | ( func << 8 ) | ( offset & 0xFC ) | ( ( uint32 ) 0x80000000 );
+
+      lib::out( config_address, address );
+      lib::out( config_data, value );
+    }
+
+    uint8 PCI::Device::capability( uint8 id, uint8 after ) {
+      // the status bit 4 tells if there is a list at all
+      if ( not ( ( read( 0x04 ) >> 16 ) & 0x10 ) )
+        return 0;
+
+      uint8 offset = after ? ( read( after ) >> 8 ) & 0xFC : config.standart.capabilities_Pointer & 0xFC;
+
+      // a broken list could loop, there is room for 48 capabilities at most
+      for ( uint32 i = 0; offset && i < 48; ++i ) {
+        uint32 header = read( offset );
+
+        if ( ( header & 0xFF ) == id )
+          return offset;
+
+        offset = ( header >> 8 ) & 0xFC;
+      }
+
+      return 0;
+    }
+
     PCI::PCI() {
 
     }
@@ -100,7 +149,9 @@ namespace kernel {
 
               uint32 classid = ( uint32 ) d->config.classcode << 16 | ( uint32 ) d->config.subclass << 8
                   | d->config.progif;
+              devices_lock.writeEnter();
               devices.put( classid, d );
+              devices_lock.writeLeave();
 
               deviceDetected.emit( d );
 
@@ -110,6 +161,17 @@ namespace kernel {
       }
     }
 
+    PCI::Device* PCI::find( uint32 classid ) {
+      devices_lock.readEnter();
+
+      DeviceMap::Node* n = devices.find( classid );
+      Device* d = n ? n->value : 0;
+
+      devices_lock.readLeave();
+
+      return d;
+    }
+
     PCI::~PCI() {
     }
 
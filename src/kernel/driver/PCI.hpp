@@ -11,6 +11,7 @@
 #include <cpp.hpp>
 #include <lib/collection/Map.hpp>
 #include <lib/sync/Mutex.hpp>
+#include <lib/sync/RWLock.hpp>
 #include <lib/Signal.hpp>
 #include <lib/File.hpp>
 
@@ -130,6 +131,13 @@ namespace kernel {
 
             void write( uint32 bus, uint32 device, uint32 func );
 
+            /**
+             * Writes a single double word of the block back to the device.
+             *
+             * @param offset The index in data.
+             */
+            void write( uint32 bus, uint32 device, uint32 func, uint8 offset );
+
             static bool isValid( uint32 bus, uint32 device, uint32 func );
 
         }__attribute__((__packed__));
@@ -294,14 +302,46 @@ namespace kernel {
              * @param F
              */
             Device( uint8 B, uint8 D, uint8 F );
+
+            /**
+             * Sets bits in the command register, e.g. CMD_Bus_Master.
+             */
+            void enable( uint16 flags );
+
+            /**
+             * Reads a double word of the configuration space, also beyond the header.
+             *
+             * @param offset The byte offset, double word aligned.
+             */
+            uint32 read( uint8 offset );
+
+            void write( uint8 offset, uint32 value );
+
+            /**
+             * Walks the capability list.
+             *
+             * @param id The capability id, e.g. 0x09 vendor specific.
+             * @param after Continues the search behind this capability, 0 starts at the head.
+             * @return The offset of the capability, 0 if there is none.
+             */
+            uint8 capability( uint8 id, uint8 after = 0 );
         };
 
         PCI();
 
         typedef lib::collection::Map< uint32, Device* > DeviceMap;
         DeviceMap devices;
+        lib::sync::RWLock devices_lock; ///< Guards devices, find() only takes the read lock.
         lib::Signal< Device* > deviceDetected;
 
+        /**
+         * Looks up a device by its class code.
+         *
+         * @param classid classcode << 16 | subclass << 8 | progif
+         * @return The device or null.
+         */
+        Device* find( uint32 classid );
+
         /**
          * @attention Scans only the first 10 busses, instead of all 256, because it is extreme unlikely to see more than 10 busses!
          */
@@ -0,0 +1,59 @@
+/**
+ * RamDisk.cpp
+ *
+ * @since 19.10.2026
+ * @author Arne Simon => email::[arne_simon@gmx.de]
+ */
+
+#include "RamDisk.hpp"
+#include <kernel/driver/iosched/NoopScheduler.hpp>
+#include <kernel/System.hpp>
+#include <lib/std.hpp>
+
+namespace kernel {
+
+  namespace driver {
+
+    RamDisk::RamDisk( uint32 sectors ) {
+      uint32 pages = ( sectors * SectorSize + PhysicalMemory::PAGE_SIZE - 1 ) / PhysicalMemory::PAGE_SIZE;
+
+      elevator( new NoopScheduler() ); // nothing to seek
+
+      memory = ( uint8* ) System::physical_memory.alloc( pages );
+      size = pages * ( PhysicalMemory::PAGE_SIZE / SectorSize );
+
+      lib::memset( memory, 0, pages * PhysicalMemory::PAGE_SIZE );
+    }
+
+    bool RamDisk::start( Request* r ) {
+      uint8* disk = memory + ( uint32 ) r->lba * SectorSize;
+      Cursor cursor( r );
+
+      while ( true ) {
+        uint32 length;
+        uint8* frame = ( uint8* ) cursor.run( length );
+
+        if ( length == 0 )
+          break;
+
+        if ( r->direction == Request::Write )
+          lib::memcpy( disk, frame, length );
+        else
+          lib::memcpy( frame, disk, length );
+
+        disk += length;
+        cursor.advance( length );
+      }
+
+      end( r, 0 );
+
+      return true;
+    }
+
+    RamDisk::~RamDisk() {
+      System::physical_memory.free( memory );
+    }
+
+  }
+
+}
@@ -0,0 +1,59 @@
+/**
+ * RamDisk.hpp
+ *
+ * @since 19.10.2026
+ * @author Arne Simon => email::[arne_simon@gmx.de]
+ */
+
+#ifndef KERNEL_DRIVER_RAMDISK_HPP_
+#define KERNEL_DRIVER_RAMDISK_HPP_
+
+#include <cpp.hpp>
+#include <kernel/driver/BlockDevice.hpp>
+
+namespace kernel {
+
+  namespace driver {
+
+    /**
+     * A drive in physical memory.
+     *
+     * start() copies the segments right away and ends the request before
+     * returning, there is no interrupt and nothing to poll. Useful to
+     * measure the overhead of the request layer itself, or as scratch
+     * space for a file system.
+     *
+     * @code
+     * kernel::driver::RamDisk ram( 8192 ); // 4 MByte
+     * uint8* buffer = ( uint8* ) System::physical_memory.alloc();
+     * uint64 start = lib::rdtsc();
+     *
+     * for ( uint32 i = 0; i < 100000; ++i )
+     *   ram.readSector( 8, ( i * 8 ) % 8192, buffer );
+     *
+     * system->video << "cycles per request " << ( uint32 ) ( ( lib::rdtsc() - start ) / 100000 ) << "\n";
+     * @endcode
+     *
+     * @since 19.10.2026
+     * @author Arne Simon => email::[arne_simon@gmx.de]
+     */
+    class RamDisk: public BlockDevice {
+      protected:
+        uint8* memory; ///< Physically contiguous, size sectors long.
+
+        bool start( Request* r );
+
+      public:
+        /**
+         * @param sectors The size, rounded up to whole pages.
+         */
+        RamDisk( uint32 sectors );
+
+        virtual ~RamDisk();
+    };
+
+  }
+
+}
+
+#endif /* KERNEL_DRIVER_RAMDISK_HPP_ */
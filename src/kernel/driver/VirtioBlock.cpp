@@ -0,0 +1,462 @@
+/**
+ * VirtioBlock.cpp
+ *
+ * @since 19.10.2026
+ * @author Arne Simon => email::[arne_simon@gmx.de]
+ */
+
+#include "VirtioBlock.hpp"
+#include <kernel/driver/iosched/NoopScheduler.hpp>
+#include <kernel/System.hpp>
+#include <kernel/Futex.hpp>
+#include <lib/sync/Atomic.hpp>
+#include <lib/std.hpp>
+
+namespace kernel {
+
+  namespace driver {
+
+    VirtioBlock::Queue::Queue()
+        : index( 0 ), size( 0 ), desc( 0 ), avail( 0 ), used( 0 ), used_event( 0 ), avail_event( 0 ), notify( 0 ),
+          slots( 0 ), free_count( 0 ), last_used( 0 ), kicked( 0 ), submitted( 0 ), notifications( 0 ) {
+    }
+
+    VirtioBlock::VirtioBlock( PCI::Device* dev )
+        : _device( dev ), common( 0 ), isr( 0 ), config( 0 ), notify_base( 0 ), notify_multiplier( 0 ),
+          event_idx( false ), write_back( false ), queue_count( 0 ) {
+
+      // the host schedules the real disk, merging is all that is left to do here
+      elevator( new NoopScheduler() );
+      max_pages = IndirectCount - 2;
+
+      _device->enable( PCI::CMD_Memory_Space | PCI::CMD_Bus_Master );
+
+      // the structures are spread over the BARs, each announced by a vendor capability
+      for ( uint8 cap = _device->capability( 0x09 ); cap; cap = _device->capability( 0x09, cap ) ) {
+        uint8 type = _device->read( cap ) >> 24;
+        uint32 base = bar( _device->read( cap + 4 ) & 0xFF );
+        uint32 offset = _device->read( cap + 8 );
+
+        if ( base == 0 )
+          continue;
+
+        if ( type == CapCommon && common == 0 )
+          common = ( volatile CommonConfig* ) ( base + offset );
+        else if ( type == CapNotify && notify_base == 0 ) {
+          notify_base = base + offset;
+          notify_multiplier = _device->read( cap + 16 );
+        }
+        else if ( type == CapISR && isr == 0 )
+          isr = ( volatile uint8* ) ( base + offset );
+        else if ( type == CapDevice && config == 0 )
+          config = ( volatile DeviceConfig* ) ( base + offset );
+      }
+
+      if ( common == 0 || notify_base == 0 || isr == 0 || config == 0 ) {
+        system->video << "virtio - the device has no modern interface!\n";
+        return;
+      }
+
+      common->device_status = 0; // reset
+
+      while ( common->device_status )
+        lib::sync::relax();
+
+      common->device_status = StatusAcknowledge;
+      common->device_status |= StatusDriver;
+
+      common->device_feature_select = 0;
+      uint32 low = common->device_feature;
+      common->device_feature_select = 1;
+      uint32 high = common->device_feature;
+
+      if ( not ( high & FeatureVersion1 ) || not ( low & FeatureIndirect ) ) {
+        common->device_status |= StatusFailed;
+        system->video << "virtio - the device lacks version 1 or indirect descriptors!\n";
+        return;
+      }
+
+      low &= FeatureIndirect | FeatureEventIdx | FeatureMQ | FeatureFlush;
+
+      common->driver_feature_select = 0;
+      common->driver_feature = low;
+      common->driver_feature_select = 1;
+      common->driver_feature = FeatureVersion1;
+
+      common->device_status |= StatusFeaturesOK;
+
+      if ( not ( common->device_status & StatusFeaturesOK ) ) {
+        common->device_status |= StatusFailed;
+        system->video << "virtio - the device refused our features!\n";
+        return;
+      }
+
+      event_idx = low & FeatureEventIdx;
+      write_back = low & FeatureFlush;
+
+      // one queue per cpu, as far as the device has them
+      uint32 wanted = low & FeatureMQ ? config->num_queues : 1;
+
+      wanted = lib::min( wanted, lib::min( MaxQueues, System::MaxCPUs ) );
+
+      for ( uint16 i = 0; i < wanted; ++i ) {
+        if ( not setup( i ) )
+          break;
+
+        queue_count++;
+      }
+
+      if ( queue_count == 0 ) {
+        common->device_status |= StatusFailed;
+        return;
+      }
+
+      size = config->capacity | ( ( uint64 ) config->capacity_high << 32 );
+
+      system->attach( System::PIC_Master_Offset + _device->config.standart.interrupt_line, this );
+
+      common->device_status |= StatusDriverOK;
+
+      system->video.color( Video::LightBlue );
+      system->video << "virtio Drive " << ( uint32 ) ( size >> 11 ) << "MByte " << queue_count << " queues\n";
+      system->video.color( Video::LightGrey );
+    }
+
+    uint32 VirtioBlock::bar( uint8 index ) {
+      if ( index > 5 )
+        return 0;
+
+      uint32 b = _device->config.data[ 4 + index ];
+
+      if ( b & 0x01 ) // I/O space
+        return 0;
+
+      if ( ( b & 0x06 ) == 0x04 && ( index == 5 || _device->config.data[ 5 + index ] ) )
+        return 0; // 64 bit and above 4 GByte
+
+      return b & 0xFFFFFFF0;
+    }
+
+    bool VirtioBlock::setup( uint16 index ) {
+      Queue& q = queues[ index ];
+
+      common->queue_select = index;
+
+      uint16 max = common->queue_size;
+
+      if ( max == 0 )
+        return false;
+
+      // the ring index wraps by masking, so the size is a power of two
+      q.size = QueueSize;
+
+      while ( q.size > max )
+        q.size >>= 1;
+
+      common->queue_size = q.size;
+
+      // descriptors, available and used ring fit one page for QueueSize entries
+      uint32 page = System::physical_memory.alloc();
+      uint32 pages = ( q.size * sizeof(Slot) + PhysicalMemory::PAGE_SIZE - 1 ) / PhysicalMemory::PAGE_SIZE;
+
+      lib::memset( ( void* ) page, 0, PhysicalMemory::PAGE_SIZE );
+
+      q.index = index;
+      q.desc = ( Descriptor* ) page;
+      q.avail = ( Available* ) ( page + 1024 );
+      q.used = ( Used* ) ( page + 2048 );
+      q.used_event = &q.avail->ring[ q.size ];
+      q.avail_event = ( volatile uint16* ) &q.used->ring[ q.size ];
+      q.slots = ( Slot* ) System::physical_memory.alloc( pages );
+
+      lib::memset( q.slots, 0, pages * PhysicalMemory::PAGE_SIZE );
+
+      for ( uint16 i = 0; i < q.size; ++i )
+        q.free[ i ] = i;
+
+      q.free_count = q.size;
+      q.notify = ( volatile uint16* ) ( notify_base + common->queue_notify_off * notify_multiplier );
+
+      common->queue_desc = ( uint32 ) q.desc;
+      common->queue_desc_high = 0;
+      common->queue_driver = ( uint32 ) q.avail;
+      common->queue_driver_high = 0;
+      common->queue_device = ( uint32 ) q.used;
+      common->queue_device_high = 0;
+      common->queue_enable = 1;
+
+      return true;
+    }
+
+    bool VirtioBlock::claim( Queue& q, uint16& slot ) {
+      q.lock.enter();
+
+      bool ok = q.free_count != 0;
+
+      if ( ok )
+        slot = q.free[ --q.free_count ];
+
+      q.lock.leave();
+
+      return ok;
+    }
+
+    void VirtioBlock::release( Queue& q, uint16 slot ) {
+      q.lock.enter();
+      q.free[ q.free_count++ ] = slot;
+      q.lock.leave();
+    }
+
+    void VirtioBlock::submit( Queue& q, uint16 slot ) {
+      q.lock.enter();
+
+      uint16 idx = q.avail->idx;
+
+      q.avail->ring[ idx & ( q.size - 1 ) ] = slot;
+      lib::sync::barrier(); // the entry before the index
+      q.avail->idx = ++idx;
+      q.submitted++;
+
+      q.lock.leave();
+    }
+
+    void VirtioBlock::buildFlush( Queue& q, uint16 slot ) {
+      Slot& s = q.slots[ slot ];
+      Descriptor* d = s.table;
+
+      s.header.type = TypeFlush;
+      s.header.reserved = 0;
+      s.header.sector = 0;
+      s.header.sector_high = 0;
+      s.status = 0xFF;
+
+      d[ 0 ].address = ( uint32 ) &s.header;
+      d[ 0 ].address_high = 0;
+      d[ 0 ].length = sizeof(Header);
+      d[ 0 ].flags = DescNext;
+      d[ 0 ].next = 1;
+
+      d[ 1 ].address = ( uint32 ) &s.status;
+      d[ 1 ].address_high = 0;
+      d[ 1 ].length = 1;
+      d[ 1 ].flags = DescWrite;
+      d[ 1 ].next = 0;
+
+      q.desc[ slot ].address = ( uint32 ) d;
+      q.desc[ slot ].address_high = 0;
+      q.desc[ slot ].length = 2 * sizeof(Descriptor);
+      q.desc[ slot ].flags = DescIndirect;
+      q.desc[ slot ].next = 0;
+    }
+
+    void VirtioBlock::notify( Queue& q ) {
+      q.lock.enter();
+
+      uint16 idx = q.avail->idx;
+
+      if ( idx != q.kicked ) {
+        // the device has to see the index before we read what it asked for
+        lib::sync::fence();
+
+        bool kick;
+
+        if ( event_idx )
+          kick = ( uint16 ) ( idx - *q.avail_event - 1 ) < ( uint16 ) ( idx - q.kicked );
+        else
+          kick = not ( q.used->flags & UsedNoNotify );
+
+        q.kicked = idx;
+
+        if ( kick ) {
+          *q.notify = q.index;
+          q.notifications++;
+        }
+      }
+
+      q.lock.leave();
+    }
+
+    void VirtioBlock::complete( Queue& q ) {
+      Request* done[ QueueSize ];
+      uint8 error[ QueueSize ];
+      uint16 again[ QueueSize ]; // FUA writes, their flush follows
+      uint32 n = 0;
+      uint32 m = 0;
+
+      q.lock.enter();
+
+      do {
+        while ( q.last_used != q.used->idx ) {
+          lib::sync::barrier(); // the index before the entry
+
+          UsedElement& e = q.used->ring[ q.last_used & ( q.size - 1 ) ];
+          Slot& s = q.slots[ e.id ];
+
+          q.last_used++;
+
+          if ( s.fua && s.status == 0 ) {
+            s.fua = false;
+            buildFlush( q, e.id );
+            again[ m++ ] = e.id;
+            continue;
+          }
+
+          done[ n ] = s.request;
+          error[ n ] = s.status == 0 ? 0 : 1;
+          n++;
+
+          q.free[ q.free_count++ ] = e.id;
+        }
+
+        if ( not event_idx )
+          break;
+
+        // ask for the next interrupt, and catch what got used meanwhile
+        *q.used_event = q.last_used;
+        lib::sync::fence();
+      } while ( q.last_used != q.used->idx );
+
+      q.lock.leave();
+
+      for ( uint32 i = 0; i < m; ++i )
+        submit( q, again[ i ] );
+
+      if ( m )
+        notify( q );
+
+      // ending starts the next requests, which takes the lock again
+      for ( uint32 i = 0; i < n; ++i )
+        end( done[ i ], error[ i ] );
+    }
+
+    bool VirtioBlock::start( Request* r ) {
+      Queue& q = queues[ System::cpu() % queue_count ];
+      uint16 slot;
+      bool flush = r->flags & Request::Flush;
+
+      // a device writing through has nothing to flush
+      if ( flush && not write_back ) {
+        end( r, 0 );
+        return true;
+      }
+
+      if ( not claim( q, slot ) )
+        return false;
+
+      Slot& s = q.slots[ slot ];
+      Descriptor* d = s.table;
+      uint32 n = 0;
+
+      s.request = r;
+      s.fua = write_back && r->direction && ( r->flags & Request::Fua );
+
+      if ( flush ) {
+        buildFlush( q, slot );
+        submit( q, slot );
+        return true;
+      }
+
+      s.header.type = r->direction ? TypeOut : TypeIn;
+      s.header.reserved = 0;
+      s.header.sector = ( uint32 ) r->lba;
+      s.header.sector_high = ( uint32 ) ( r->lba >> 32 );
+      s.status = 0xFF;
+
+      // the slot lives in kernel memory, which is its physical address
+      d[ n ].address = ( uint32 ) &s.header;
+      d[ n ].length = sizeof(Header);
+      d[ n ].flags = 0;
+      n++;
+
+      Cursor cursor( r );
+
+      while ( true ) {
+        uint32 length;
+        uint32 frame = cursor.run( length );
+
+        if ( length == 0 )
+          break;
+
+        if ( n > 1 && d[ n - 1 ].address + d[ n - 1 ].length == frame ) {
+          d[ n - 1 ].length += length;
+        }
+        else {
+          if ( n == IndirectCount - 1 ) {
+            // the buffer has too many pages
+            release( q, slot );
+            end( r, 1 );
+            return true;
+          }
+
+          d[ n ].address = frame;
+          d[ n ].length = length;
+          d[ n ].flags = r->direction ? 0 : DescWrite;
+          n++;
+        }
+
+        cursor.advance( length );
+      }
+
+      d[ n ].address = ( uint32 ) &s.status;
+      d[ n ].length = 1;
+      d[ n ].flags = DescWrite;
+      n++;
+
+      for ( uint32 i = 0; i < n; ++i ) {
+        d[ i ].address_high = 0;
+
+        if ( i + 1 < n ) {
+          d[ i ].flags |= DescNext;
+          d[ i ].next = i + 1;
+        }
+      }
+
+      q.desc[ slot ].address = ( uint32 ) d;
+      q.desc[ slot ].address_high = 0;
+      q.desc[ slot ].length = n * sizeof(Descriptor);
+      q.desc[ slot ].flags = DescIndirect;
+      q.desc[ slot ].next = 0;
+
+      submit( q, slot );
+
+      return true;
+    }
+
+    void VirtioBlock::kick() {
+      for ( uint32 i = 0; i < queue_count; ++i )
+        notify( queues[ i ] );
+    }
+
+    void VirtioBlock::poll() {
+      for ( uint32 i = 0; i < queue_count; ++i )
+        complete( queues[ i ] );
+    }
+
+    bool VirtioBlock::call() {
+      uint8 status = *isr; // reading acknowledges the interrupt
+
+      if ( status == 0 )
+        return false;
+
+      poll();
+
+      return true;
+    }
+
+    VirtioBlock::~VirtioBlock() {
+      if ( queue_count == 0 )
+        return;
+
+      common->device_status = 0;
+
+      system->detach( System::PIC_Master_Offset + _device->config.standart.interrupt_line, this );
+
+      for ( uint32 i = 0; i < queue_count; ++i ) {
+        System::physical_memory.free( queues[ i ].desc );
+        System::physical_memory.free( queues[ i ].slots );
+      }
+    }
+
+  }
+
+}
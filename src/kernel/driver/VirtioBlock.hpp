@@ -0,0 +1,287 @@
+/**
+ * VirtioBlock.hpp
+ *
+ * @since 19.10.2026
+ * @author Arne Simon => email::[arne_simon@gmx.de]
+ */
+
+#ifndef KERNEL_DRIVER_VIRTIOBLOCK_HPP_
+#define KERNEL_DRIVER_VIRTIOBLOCK_HPP_
+
+#include <cpp.hpp>
+#include <kernel/ISR.hpp>
+#include <kernel/driver/PCI.hpp>
+#include <kernel/driver/BlockDevice.hpp>
+#include <lib/sync/TicketLock.hpp>
+
+namespace kernel {
+
+  namespace driver {
+
+    /**
+     * A virtio block device behind the modern (virtio 1.0) PCI transport.
+     *
+     * The common, notify, ISR and device configuration structures are found
+     * by the vendor specific PCI capabilities and used at the physical
+     * address of their BAR.
+     *
+     * @section virtioqueues Queues
+     * Every cpu starts requests on its own split virtqueue, up to the
+     * number of queues the device offers with VIRTIO_BLK_F_MQ. A request
+     * takes one ring descriptor, which points to an indirect table with the
+     * request header, the segment pages and the status byte. So a queue of
+     * QueueSize entries has as many requests in flight, and the descriptor
+     * of a request is the index of its slot. A full queue leaves the
+     * requests in the queue of the BlockDevice.
+     *
+     * @section virtioevents Notification Suppression
+     * kick() notifies once per batch of started requests, and with
+     * VIRTIO_RING_F_EVENT_IDX only if the device asked for the new
+     * available index, so requests added while it still works on the queue
+     * need no notification at all. The other way round
+     * the driver publishes the last used index it has seen, the device
+     * interrupts again after passing it. The device interrupts on its
+     * legacy INTx line, the routine reaps the used rings of all queues.
+     *
+     * A device with VIRTIO_BLK_F_FLUSH may cache writes, flush requests
+     * become VIRTIO_BLK_T_FLUSH. There is no FUA write in virtio, so a FUA
+     * request reuses its slot for a flush before it ends. Without the
+     * feature the device writes through and both are no-ops.
+     *
+     * Devices without VIRTIO_F_VERSION_1 or VIRTIO_RING_F_INDIRECT_DESC are
+     * not driven.
+     *
+     * @section virtiobenchmark Notification Benchmark
+     * kernel::Benchmark::iops() lets four threads read random 4 KByte
+     * blocks, the IOPS and the notifications per request show how many
+     * requests got batched.
+     *
+     * @note http://docs.oasis-open.org/virtio/virtio/v1.0/virtio-v1.0.html
+     * @note http://wiki.osdev.org/Virtio
+     *
+     * @since 19.10.2026
+     * @author Arne Simon => email::[arne_simon@gmx.de]
+     */
+    class VirtioBlock: public BlockDevice, public ISR {
+      public:
+        static const uint16 Vendor = 0x1AF4;
+        static const uint16 QueueSize = 64; ///< The largest queue we set up.
+        static const uint32 MaxQueues = 8;
+        static const uint32 IndirectCount = 32; ///< The indirect descriptors of a request.
+
+      protected:
+        // PCI capability types
+        static const uint8 CapCommon = 1;
+        static const uint8 CapNotify = 2;
+        static const uint8 CapISR = 3;
+        static const uint8 CapDevice = 4;
+
+        // Device Status
+        static const uint8 StatusAcknowledge = 0x01;
+        static const uint8 StatusDriver = 0x02;
+        static const uint8 StatusDriverOK = 0x04;
+        static const uint8 StatusFeaturesOK = 0x08;
+        static const uint8 StatusFailed = 0x80;
+
+        // Features, low and high double word
+        static const uint32 FeatureFlush = 1 << 9; ///< VIRTIO_BLK_F_FLUSH
+        static const uint32 FeatureMQ = 1 << 12; ///< VIRTIO_BLK_F_MQ
+        static const uint32 FeatureIndirect = 1 << 28; ///< VIRTIO_RING_F_INDIRECT_DESC
+        static const uint32 FeatureEventIdx = 1 << 29; ///< VIRTIO_RING_F_EVENT_IDX
+        static const uint32 FeatureVersion1 = 1 << 0; ///< VIRTIO_F_VERSION_1, bit 32
+
+        // Descriptor flags
+        static const uint16 DescNext = 1;
+        static const uint16 DescWrite = 2; ///< The device writes into the buffer.
+        static const uint16 DescIndirect = 4;
+
+        static const uint16 UsedNoNotify = 1;
+
+        static const uint32 TypeIn = 0;
+        static const uint32 TypeOut = 1;
+        static const uint32 TypeFlush = 4;
+
+        struct CommonConfig {
+            uint32 device_feature_select;
+            uint32 device_feature;
+            uint32 driver_feature_select;
+            uint32 driver_feature;
+            uint16 msix_config;
+            uint16 num_queues;
+            uint8 device_status;
+            uint8 config_generation;
+            uint16 queue_select;
+            uint16 queue_size;
+            uint16 queue_msix_vector;
+            uint16 queue_enable;
+            uint16 queue_notify_off;
+            uint32 queue_desc;
+            uint32 queue_desc_high;
+            uint32 queue_driver;
+            uint32 queue_driver_high;
+            uint32 queue_device;
+            uint32 queue_device_high;
+        }__attribute__((packed));
+
+        struct DeviceConfig {
+            uint32 capacity; ///< In sectors.
+            uint32 capacity_high;
+            uint32 size_max;
+            uint32 seg_max;
+            uint16 cylinders;
+            uint8 heads;
+            uint8 sectors;
+            uint32 blk_size;
+            uint8 physical_block_exp;
+            uint8 alignment_offset;
+            uint16 min_io_size;
+            uint32 opt_io_size;
+            uint8 writeback;
+            uint8 unused0;
+            uint16 num_queues;
+        }__attribute__((packed));
+
+        struct Descriptor {
+            uint32 address;
+            uint32 address_high;
+            uint32 length;
+            uint16 flags;
+            uint16 next;
+        };
+
+        struct Available {
+            uint16 flags;
+            volatile uint16 idx;
+            uint16 ring[ QueueSize ]; ///< Followed by used_event, behind the last entry of the real size.
+        };
+
+        struct UsedElement {
+            uint32 id;
+            uint32 length;
+        };
+
+        struct Used {
+            volatile uint16 flags;
+            volatile uint16 idx;
+            UsedElement ring[ QueueSize ]; ///< Followed by avail_event.
+        };
+
+        struct Header {
+            uint32 type;
+            uint32 reserved;
+            uint32 sector;
+            uint32 sector_high;
+        };
+
+        /**
+         * A request slot, read by the device through the indirect table.
+         */
+        struct Slot {
+            Descriptor table[ IndirectCount ];
+            Header header;
+            volatile uint8 status;
+            BlockDevice::Request* request; ///< The request the slot transfers.
+            bool fua; ///< A flush follows the write in the same slot.
+        }__attribute__((aligned(16)));
+
+      public:
+        /**
+         * A split virtqueue.
+         */
+        class Queue {
+          public:
+            uint16 index;
+            uint16 size;
+            Descriptor* desc;
+            Available* avail;
+            Used* used;
+            volatile uint16* used_event; ///< Written by us, interrupt after this used index.
+            volatile uint16* avail_event; ///< Written by the device, notify after this available index.
+            volatile uint16* notify;
+            Slot* slots;
+            uint16 free[ QueueSize ]; ///< The stack of free slots.
+            uint32 free_count;
+            uint16 last_used; ///< The used index we reaped up to.
+            uint16 kicked; ///< The available index at the last notification check, by kick().
+            lib::sync::TicketLock lock;
+            uint32 submitted; ///< Requests made available.
+            uint32 notifications; ///< Requests which notified the device.
+
+            Queue();
+        };
+
+      protected:
+        PCI::Device* _device;
+        volatile CommonConfig* common;
+        volatile uint8* isr;
+        volatile DeviceConfig* config;
+        uint32 notify_base;
+        uint32 notify_multiplier;
+        bool event_idx; ///< VIRTIO_RING_F_EVENT_IDX was negotiated.
+        bool write_back; ///< VIRTIO_BLK_F_FLUSH was negotiated, the device may cache writes.
+
+        /**
+         * @return The address of a memory BAR, 0 for I/O or 64 bit BARs above 4 GByte.
+         */
+        uint32 bar( uint8 index );
+
+        /**
+         * Sets up the virtqueue of the given index.
+         */
+        bool setup( uint16 index );
+
+        /**
+         * @return False if the queue is full.
+         */
+        bool claim( Queue& q, uint16& slot );
+
+        void release( Queue& q, uint16 slot );
+
+        /**
+         * Makes the slot available, without notifying the device.
+         */
+        void submit( Queue& q, uint16 slot );
+
+        /**
+         * Builds a flush in the slot, without data.
+         */
+        void buildFlush( Queue& q, uint16 slot );
+
+        /**
+         * Notifies the device of the new available entries if it waits for them.
+         */
+        void notify( Queue& q );
+
+        /**
+         * Ends the requests the device has used.
+         */
+        void complete( Queue& q );
+
+        /**
+         * Builds the request in a slot of the queue of the current cpu.
+         */
+        bool start( Request* r );
+
+        void kick();
+
+        void poll();
+
+      public:
+        Queue queues[ MaxQueues ];
+        uint32 queue_count; ///< 0 if the device could not be driven.
+
+        VirtioBlock( PCI::Device* dev );
+
+        /**
+         * Reaps the used rings.
+         */
+        bool call();
+
+        virtual ~VirtioBlock();
+    };
+
+  }
+
+}
+
+#endif /* KERNEL_DRIVER_VIRTIOBLOCK_HPP_ */
@@ -42,6 +42,9 @@ namespace kernel {
       }
 
       Elf32Process::Elf32Process( Elf32* Elf ) {
+        usermode = true;
+        virtual_memory.page_flags |= VirtualMemory::User;
+
         for ( uint32 i = 0; i < Elf->header->phnum; ++i ) {
           if ( Elf->progammheaders[ i ]->type == Elf32::ProgrammHeader::LOAD ) {
             system->video << Elf->progammheaders[ i ]->filesz << " : " << Elf->progammheaders[ i ]->memsz << "\n";
@@ -51,11 +54,13 @@ namespace kernel {
             system->video << "\n";
 
             virtual_memory.map( ( uint32 ) ( Elf->data + Elf->progammheaders[ i ]->offset ),
-                Elf->progammheaders[ i ]->vaddr );
-            virtual_memory.map( 0xb8000, 0xb8000 );
+                Elf->progammheaders[ i ]->vaddr, virtual_memory.page_flags );
           }
         }
 
+        // the screen stays the kernel's, a process prints through lib::Syscall::Write
+        virtual_memory.map( 0xb8000, 0xb8000 );
+
         new Thread( this, Elf->header->entry, 4000 );
       }
 
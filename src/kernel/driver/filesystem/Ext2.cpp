@@ -49,7 +49,7 @@ namespace kernel {
       idx %= ( 512 / sizeof(INode) ); // calculate our index for the part of the inode table, we are reading
 
       // read the sector, where or inode is located in the table
-      _fs->drive->readSector( 1, addr, _fs->tmp_inode_table );
+      _fs->cache->read( _fs->drive, addr, 1, _fs->tmp_inode_table );
 
       *inode = _fs->tmp_inode_table[ idx ]; // copy inode data
     }
@@ -62,11 +62,11 @@ namespace kernel {
 
       idx %= ( 512 / sizeof(INode) ); // calculate our index for the part of the inode table, we are reading
 
-      _fs->drive->readSector( 1, addr, _fs->tmp_inode_table ); // read on sector
+      _fs->cache->read( _fs->drive, addr, 1, _fs->tmp_inode_table ); // read on sector
 
       _fs->tmp_inode_table[ idx ] = *inode; // copy inode data
 
-      _fs->drive->writeSector( 1, addr, _fs->tmp_inode_table ); // write on sector
+      _fs->cache->write( _fs->drive, addr, 1, _fs->tmp_inode_table ); // write on sector
     }
 
     void Ext2::File::read( void** data, uint32* size ) {
@@ -79,7 +79,7 @@ namespace kernel {
 
       // read direct blocks
       for ( uint8 i = 0; blks < inode->blocks && i < 12; ++i ) {
-        _fs->drive->readSector( _fs->block_sector_size, _fs->block2lba( inode->block[ i ] ), it );
+        _fs->cache->read( _fs->drive, _fs->block2lba( inode->block[ i ] ), _fs->block_sector_size, it, &readahead );
         it += _fs->block_size; // increment data pointer
         blks += blks_per_read; // increment blocks read
       }
@@ -89,10 +89,11 @@ namespace kernel {
         uint32 max = _fs->block_size / sizeof(uint32);
         uint32* firstlevel = new uint32[ max ];
 
-        _fs->drive->readSector( _fs->block_sector_size, _fs->block2lba( inode->first_indirect_block ), firstlevel );
+        _fs->cache->read( _fs->drive, _fs->block2lba( inode->first_indirect_block ),
+            _fs->block_sector_size, firstlevel );
 
         for ( uint32 i = 0; blks < inode->blocks && i < max; ++i ) {
-          _fs->drive->readSector( _fs->block_sector_size, _fs->block2lba( firstlevel[ i ] ), it );
+          _fs->cache->read( _fs->drive, _fs->block2lba( firstlevel[ i ] ), _fs->block_sector_size, it, &readahead );
           it += _fs->block_size; // increment data pointer
           blks += blks_per_read; // increment blocks read
         }
@@ -102,13 +103,15 @@ namespace kernel {
           uint32 max = _fs->block_size / sizeof(uint32);
           uint32* secondlevel = new uint32[ max ];
 
-          _fs->drive->readSector( _fs->block_sector_size, _fs->block2lba( inode->double_indirect_block ), firstlevel );
+          _fs->cache->read( _fs->drive, _fs->block2lba( inode->double_indirect_block ),
+              _fs->block_sector_size, firstlevel );
 
           for ( uint32 i = 0; blks < inode->blocks && i < max; ++i ) {
-            _fs->drive->readSector( _fs->block_sector_size, _fs->block2lba( firstlevel[ i ] ), secondlevel );
+            _fs->cache->read( _fs->drive, _fs->block2lba( firstlevel[ i ] ), _fs->block_sector_size, secondlevel );
 
             for ( uint32 j = 0; blks < inode->blocks && j < max; ++j ) {
-              _fs->drive->readSector( _fs->block_sector_size, _fs->block2lba( secondlevel[ j ] ), it );
+              _fs->cache->read( _fs->drive, _fs->block2lba( secondlevel[ j ] ), _fs->block_sector_size, it,
+                  &readahead );
               it += _fs->block_size; // increment data pointer
               blks += blks_per_read; // increment blocks read
             }
@@ -118,17 +121,18 @@ namespace kernel {
           if ( blks < inode->blocks ) {
             uint32* thirdlevel = new uint32[ max ];
 
-            _fs->drive->readSector( _fs->block_sector_size, _fs->block2lba( inode->triple_indirect_block ),
-                firstlevel );
+            _fs->cache->read( _fs->drive, _fs->block2lba( inode->triple_indirect_block ),
+                _fs->block_sector_size, firstlevel );
 
             for ( uint32 i = 0; blks < inode->blocks && i < max; ++i ) {
-              _fs->drive->readSector( _fs->block_sector_size, _fs->block2lba( firstlevel[ i ] ), secondlevel );
+              _fs->cache->read( _fs->drive, _fs->block2lba( firstlevel[ i ] ), _fs->block_sector_size, secondlevel );
 
               for ( uint32 j = 0; blks < inode->blocks && j < max; ++j ) {
-                _fs->drive->readSector( _fs->block_sector_size, _fs->block2lba( secondlevel[ j ] ), thirdlevel );
+                _fs->cache->read( _fs->drive, _fs->block2lba( secondlevel[ j ] ), _fs->block_sector_size, thirdlevel );
 
                 for ( uint32 k = 0; blks < inode->blocks && k < max; ++k ) {
-                  _fs->drive->readSector( _fs->block_sector_size, _fs->block2lba( thirdlevel[ k ] ), it );
+                  _fs->cache->read( _fs->drive, _fs->block2lba( thirdlevel[ k ] ), _fs->block_sector_size, it,
+                      &readahead );
                   it += _fs->block_size; // increment data pointer
                   blks += blks_per_read; // increment blocks read
                 }
@@ -143,7 +147,6 @@ namespace kernel {
 
         delete firstlevel;
       }
-
     }
 
     uint32 Ext2::File::write( void* data, uint32 size ) {
@@ -158,7 +161,7 @@ namespace kernel {
           inode->block[ i ] = _fs->alloc_block( group() );
         }
 
-        _fs->drive->writeSector( _fs->block_sector_size, _fs->block2lba( inode->block[ i ] ), it );
+        _fs->cache->write( _fs->drive, _fs->block2lba( inode->block[ i ] ), _fs->block_sector_size, it );
 
         it += _fs->block_size;
         blks += blks_per_read;
@@ -174,7 +177,8 @@ namespace kernel {
           inode->first_indirect_block = _fs->alloc_block( group() );
         }
         else {
-          _fs->drive->readSector( _fs->block_sector_size, _fs->block2lba( inode->first_indirect_block ), firstlevel );
+          _fs->cache->read( _fs->drive, _fs->block2lba( inode->first_indirect_block ),
+              _fs->block_sector_size, firstlevel );
         }
 
         // writing to the first level indirect blocks
@@ -183,7 +187,7 @@ namespace kernel {
             firstlevel[ i ] = _fs->alloc_block( group() );
           }
 
-          _fs->drive->writeSector( _fs->block_sector_size, _fs->block2lba( firstlevel[ i ] ), it );
+          _fs->cache->write( _fs->drive, _fs->block2lba( firstlevel[ i ] ), _fs->block_sector_size, it );
 
           it += _fs->block_size;
           blks += blks_per_read;
@@ -198,8 +202,8 @@ namespace kernel {
             inode->double_indirect_block = _fs->alloc_block( group() );
           }
           else {
-            _fs->drive->readSector( _fs->block_sector_size, _fs->block2lba( inode->double_indirect_block ),
-                firstlevel );
+            _fs->cache->read( _fs->drive, _fs->block2lba( inode->double_indirect_block ),
+                _fs->block_sector_size, firstlevel );
           }
 
           // triple level indirect blocks
@@ -217,7 +221,8 @@ namespace kernel {
           firstlevel[ i ] = 0;
         }
 
-        _fs->drive->writeSector( _fs->block_sector_size, _fs->block2lba( inode->first_indirect_block ), firstlevel );
+        _fs->cache->write( _fs->drive, _fs->block2lba( inode->first_indirect_block ),
+            _fs->block_sector_size, firstlevel );
 
         delete firstlevel;
       }
@@ -228,6 +233,9 @@ namespace kernel {
 //            inode->block[ i ] = 0;
 //         }
 
+      // the allocations and the data only dirtied the cache, here they are committed
+      _fs->sync();
+
       return size;
     }
 
@@ -327,7 +335,7 @@ namespace kernel {
     }
 
     uint32 Ext2::alloc_inode( uint32 grp ) {
-      drive->readSector( 2, block2lba( grp_desc_table[ grp ].inode_bitmap ), tmp_inode_bitmap );
+      cache->read( drive, block2lba( grp_desc_table[ grp ].inode_bitmap ), 2, tmp_inode_bitmap );
 
       uint8* bitmap = tmp_inode_bitmap;
       uint32 freenode = 0;
@@ -345,13 +353,13 @@ namespace kernel {
       }
 
       // writing the updated inode bitmap back to the hard-drive
-      drive->writeSector( 2, block2lba( grp_desc_table[ grp ].inode_bitmap ), tmp_inode_bitmap );
+      cache->write( drive, block2lba( grp_desc_table[ grp ].inode_bitmap ), 2, tmp_inode_bitmap );
 
       grp_desc_table[ grp ].free_inodes_count--;
       sblock.free_inodecount--;
 
       // update group description table
-      drive->writeSector( 1, block2lba( 2 ), grp_desc_table );
+      cache->write( drive, block2lba( 2 ), 1, grp_desc_table );
 
       // update super block on disk
       write_superblock();
@@ -360,7 +368,7 @@ namespace kernel {
     }
 
     uint32 Ext2::alloc_block( uint32 grp ) {
-      drive->readSector( 2, block2lba( grp_desc_table[ grp ].block_bitmap ), tmp_block_bitmap );
+      cache->read( drive, block2lba( grp_desc_table[ grp ].block_bitmap ), 2, tmp_block_bitmap );
 
       uint8* bitmap = tmp_block_bitmap;
       uint32 freeblock = 0;
@@ -377,13 +385,13 @@ namespace kernel {
         bitmap++;
       }
 
-      drive->writeSector( 2, block2lba( grp_desc_table[ grp ].block_bitmap ), tmp_block_bitmap );
+      cache->write( drive, block2lba( grp_desc_table[ grp ].block_bitmap ), 2, tmp_block_bitmap );
 
       grp_desc_table[ grp ].free_blocks_count--;
       sblock.free_blockcount--;
 
       // update group description table
-      drive->writeSector( 1, block2lba( 2 ), grp_desc_table );
+      cache->write( drive, block2lba( 2 ), 1, grp_desc_table );
 
       // update super block on disk
       write_superblock();
@@ -394,7 +402,7 @@ namespace kernel {
     void Ext2::free_block( uint32 blk ) {
       uint32 grp = ( blk - 1 ) / sblock.blockper_group;
 
-      drive->readSector( 2, block2lba( grp_desc_table[ grp ].block_bitmap ), tmp_block_bitmap );
+      cache->read( drive, block2lba( grp_desc_table[ grp ].block_bitmap ), 2, tmp_block_bitmap );
 
       uint32* bitmap = ( uint32* ) tmp_block_bitmap;
 
@@ -402,13 +410,13 @@ namespace kernel {
 
       *bitmap &= ~( 1 << ( ( blk - 1 ) % 32 ) );
 
-      drive->writeSector( 2, block2lba( grp_desc_table[ grp ].block_bitmap ), tmp_block_bitmap );
+      cache->write( drive, block2lba( grp_desc_table[ grp ].block_bitmap ), 2, tmp_block_bitmap );
 
       grp_desc_table[ grp ].free_blocks_count++;
       sblock.free_blockcount++;
 
       // update group description table
-      drive->writeSector( 1, block2lba( 2 ), grp_desc_table );
+      cache->write( drive, block2lba( 2 ), 1, grp_desc_table );
 
       // update super block on disk
       write_superblock();
@@ -418,7 +426,7 @@ namespace kernel {
     void Ext2::free_inode( uint32 inode ) {
       uint32 grp = ( inode - 1 ) / sblock.inodeper_group;
 
-      drive->readSector( 2, block2lba( grp_desc_table[ grp ].inode_bitmap ), tmp_inode_bitmap );
+      cache->read( drive, block2lba( grp_desc_table[ grp ].inode_bitmap ), 2, tmp_inode_bitmap );
 
       uint32* bitmap = ( uint32* ) tmp_inode_bitmap;
 
@@ -426,13 +434,13 @@ namespace kernel {
 
       *bitmap &= ~( 1 << ( ( inode - 1 ) % 32 ) );
 
-      drive->writeSector( 2, block2lba( grp_desc_table[ grp ].inode_bitmap ), tmp_inode_bitmap );
+      cache->write( drive, block2lba( grp_desc_table[ grp ].inode_bitmap ), 2, tmp_inode_bitmap );
 
       grp_desc_table[ grp ].free_inodes_count++;
       sblock.free_inodecount++;
 
       // update group description table
-      drive->writeSector( 1, block2lba( 2 ), grp_desc_table );
+      cache->write( drive, block2lba( 2 ), 1, grp_desc_table );
 
       // update super block on disk
       write_superblock();
@@ -440,17 +448,17 @@ namespace kernel {
     }
 
     void Ext2::write_superblock() {
-      drive->writeSector( 2, partition_offset + 2, &sblock );
+      cache->write( drive, partition_offset + 2, 2, &sblock );
     }
 
     void Ext2::read_superblock() {
-      drive->readSector( 2, partition_offset + 2, &sblock );
+      cache->read( drive, partition_offset + 2, 2, &sblock );
     }
 
-    Ext2::Ext2( ATA::Drive* IDE, uint32 Partition )
-        : drive( IDE ), partition( Partition ) {
+    Ext2::Ext2( BlockDevice* IDE, uint32 Partition )
+        : drive( IDE ), cache( BufferCache::instance() ), partition( Partition ) {
 
-      ATA::MBR mbr;
+      BlockDevice::MBR mbr;
 
       drive->read( &mbr );
 
@@ -477,7 +485,7 @@ namespace kernel {
       tmp_block_bitmap = new uint8[ block_size ];
 
       // reading group description
-      drive->readSector( 1, block2lba( 2 ), grp_desc_table );
+      cache->read( drive, block2lba( 2 ), 1, grp_desc_table );
 
       root = new File( this, ROOT_INO );
     }
@@ -486,7 +494,13 @@ namespace kernel {
       return sblock.volume_name;
     }
 
+    void Ext2::sync() {
+      cache->sync( drive );
+    }
+
     Ext2::~Ext2() {
+      sync();
+
       delete root;
       delete tmp_inode_table;
       delete tmp_block_bitmap;
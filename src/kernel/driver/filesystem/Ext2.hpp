@@ -12,7 +12,8 @@
 #include <lib/String.hpp>
 #include <lib/File.hpp>
 #include <lib/collection/Map.hpp>
-#include <kernel/driver/ATA.hpp>
+#include <kernel/driver/BlockDevice.hpp>
+#include <kernel/driver/BufferCache.hpp>
 
 namespace kernel {
 
@@ -298,7 +299,8 @@ namespace kernel {
         uint8* tmp_block_bitmap;
         uint8* tmp_inode_bitmap; ///< A temporary read inode bitmap.
         INode* tmp_inode_table; ///< A temporary part of an inode table.
-        ATA::Drive *drive;
+        BlockDevice* drive;
+        BufferCache* cache; ///< All sectors go through the cache.
         uint8 partition; ///< which partition of the device we use.
         uint32 partition_offset;
         uint32 block_size; ///< The size of an ext2 block in byte.
@@ -329,6 +331,7 @@ namespace kernel {
             File* parent; ///< The parent directory.
             uint32 inode_id; ///< The inode of this file/directory.
             INode *inode; ///< Pointer to the inode structure of this inode.
+            BufferCache::Readahead readahead; ///< For the data blocks.
 
             /**
              * Gets the index in the inode table for a given INode.
@@ -382,10 +385,20 @@ namespace kernel {
 
         File *root; ///< The root directory.
 
-        Ext2( ATA::Drive* IDE, uint32 Partition );
+        Ext2( BlockDevice* IDE, uint32 Partition );
 
         char* volumename();
 
+        /**
+         * Writes the cached changes of the file system back to the drive.
+         *
+         * The commit point: metadata updates like an allocation only dirty
+         * cached sectors, here they reach the medium with one drive cache flush.
+         * File::write() ends with it, which commits mkfile() as well, it
+         * writes the directory last.
+         */
+        void sync();
+
         virtual ~Ext2();
     };
 
@@ -14,9 +14,9 @@ namespace kernel {
 
   namespace driver {
 
-    MyFS::MyFS( ATA::Drive* Drv, uint32 Partition ) :
-      drive( Drv ), partition( Partition ), bitmap( 0 ) {
-      ATA::MBR mbr;
+    MyFS::MyFS( BlockDevice* Drv, uint32 Partition ) :
+      drive( Drv ), cache( BufferCache::instance() ), partition( Partition ), bitmap( 0 ) {
+      BlockDevice::MBR mbr;
 
       drive->read( &mbr ); // reading master boot record of the drive
 
@@ -37,7 +37,7 @@ namespace kernel {
     }
 
     void MyFS::read_table() {
-      drive->readSector( 1, partition_offset, &table ); // read table data
+      cache->read( drive, partition_offset, 1, &table ); // read table data
 
       // allocate bitmap array
       if ( !bitmap ) {
@@ -45,15 +45,15 @@ namespace kernel {
       }
 
       // read the damn fucking bitmap data from harddrive. YEEHAAAAA!!!!
-      drive->readSector( table.bitmap_size, partition_offset + 1, bitmap );
+      cache->read( drive, partition_offset + 1, table.bitmap_size, bitmap );
     }
 
     void MyFS::write_table() {
       // write the table
-      drive->writeSector( 1, partition_offset, &table );
+      cache->write( drive, partition_offset, 1, &table );
 
       // write the bitmap data
-      drive->writeSector( table.bitmap_size, partition_offset + 1, bitmap );
+      cache->write( drive, partition_offset + 1, table.bitmap_size, bitmap );
     }
 
     void MyFS::mark_lba( uint32 lba, bool used ) {
@@ -135,7 +135,7 @@ namespace kernel {
       root.third = 0;
       root.fourth = 0;
 
-      drive->writeSector( 1, table.root_node, &root );
+      cache->write( drive, table.root_node, 1, &root );
     }
 
     void MyFS::File::read_blocks( void** data, uint32* size ) {
@@ -155,7 +155,7 @@ namespace kernel {
         uint32 addr[ 128 ];
 
         for ( uint32 a = 0; addr[ a ] && a < 128; ++a ) {
-          myfs->drive->readSector( 1, addr[ a ], tmp );
+          myfs->cache->read( myfs->drive, addr[ a ], 1, tmp );
 
           for ( uint32 i = 0; *size < node.size && i < 512; ++i ) {
             ( ( uint8* ) *data )[ *size ] = ( ( uint8* ) ( &tmp ) )[ i ];
@@ -178,7 +178,7 @@ namespace kernel {
         node.size += 1;
       }
 
-      myfs->drive->writeSector( 1, lba, &node );
+      myfs->cache->write( myfs->drive, lba, 1, &node );
 
       // writing frist level data blocks
       if ( node.size < size ) {
@@ -187,7 +187,7 @@ namespace kernel {
         uint32 a;
 
         if ( node.first ) {
-          myfs->drive->readSector( 1, node.first, addr );
+          myfs->cache->read( myfs->drive, node.first, 1, addr );
         }
         else {
           node.first = myfs->get_free_lba();
@@ -208,7 +208,7 @@ namespace kernel {
             node.size++;
           }
 
-          myfs->drive->writeSector( 1, addr[ a ], tmp );
+          myfs->cache->write( myfs->drive, addr[ a ], 1, tmp );
         }
 
         for ( a = 0; a < 128; ++a ) {
@@ -243,7 +243,7 @@ namespace kernel {
     MyFS::File::File( MyFS* M, uint32 LBA, File* P ) :
       lba( LBA ), myfs( M ), parent( P ) {
 
-      myfs->drive->readSector( 1, lba, &node );
+      myfs->cache->read( myfs->drive, lba, 1, &node );
     }
 
     uint32 MyFS::File::write( void* data, uint32 length ) {
@@ -283,6 +283,7 @@ namespace kernel {
 
     MyFS::~MyFS() {
       write_table();
+      cache->sync( drive );
       delete bitmap;
     }
 
@@ -9,7 +9,8 @@
 #define MYFS_HPP_
 
 #include <cpp.hpp>
-#include <kernel/driver/ATA.hpp>
+#include <kernel/driver/BlockDevice.hpp>
+#include <kernel/driver/BufferCache.hpp>
 #include <lib/File.hpp>
 #include <lib/collection/Map.hpp>
 #include <lib/String.hpp>
@@ -167,14 +168,15 @@ namespace kernel {
             };
 
             lib::sync::Mutex mutex;
-            ATA::Drive* drive;
+            BlockDevice* drive;
+            BufferCache* cache;
             uint8 partition; ///< which partition of the device to use.
             uint32 partition_offset; ///< The LBA of the first block of the partition to use.
             InfoTable table; ///< The information table.
             uint32* bitmap; ///< The allocation bitmap of free and used blocks.
             File* root;
 
-            MyFS( ATA::Drive* Drv, uint32 Partition );
+            MyFS( BlockDevice* Drv, uint32 Partition );
 
             /**
              * Formats the drive.
@@ -0,0 +1,120 @@
+/**
+ * DeadlineScheduler.cpp
+ *
+ * @since 19.10.2026
+ * @author Arne Simon => email::[arne_simon@gmx.de]
+ */
+
+#include "DeadlineScheduler.hpp"
+#include <kernel/System.hpp>
+#include <lib/std.hpp>
+
+namespace kernel {
+
+  namespace driver {
+
+    DeadlineScheduler::DeadlineScheduler()
+        : cursor( 0 ), batch( 0 ), starved( 0 ), expired( 0 ) {
+      position[ 0 ] = 0;
+      position[ 1 ] = 0;
+    }
+
+    void DeadlineScheduler::enqueue( Request* r ) {
+      sorted[ r->direction ].insert( r );
+    }
+
+    bool DeadlineScheduler::merge( Request* r ) {
+      uint32 expire = r->direction == Request::Read ? ReadExpire : WriteExpire;
+
+      // every new request passes here first, a front merge compares the deadlines
+      // without a known TSC rate all requests are expired, which degrades to FIFO
+      r->deadline = lib::rdtsc() + ( uint64 ) expire * system->shared->tsc_khz;
+
+      Queue& q = sorted[ r->direction ];
+
+      for ( Request* i = q.head; i && i->lba <= r->lba + r->length; i = i->next ) {
+        if ( backMerge( i, r ) )
+          return true;
+
+        if ( frontMerge( i, r ) ) {
+          q.replace( i, r );
+
+          if ( cursor == i )
+            cursor = r;
+
+          return true;
+        }
+      }
+
+      return false;
+    }
+
+    IOScheduler::Request* DeadlineScheduler::oldest( uint8 direction ) {
+      Request* r = sorted[ direction ].head;
+
+      for ( Request* i = r; i; i = i->next ) {
+        if ( i->deadline < r->deadline )
+          r = i;
+      }
+
+      return r;
+    }
+
+    IOScheduler::Request* DeadlineScheduler::pick() {
+      Request* r = 0;
+
+      if ( cursor && batch < FifoBatch ) {
+        r = cursor;
+      }
+      else {
+        uint8 direction;
+
+        if ( sorted[ Request::Read ].head && ( sorted[ Request::Write ].head == 0 || starved < WritesStarved ) ) {
+          direction = Request::Read;
+
+          if ( sorted[ Request::Write ].head )
+            starved++;
+        }
+        else if ( sorted[ Request::Write ].head ) {
+          direction = Request::Write;
+          starved = 0;
+        }
+        else {
+          return 0;
+        }
+
+        r = oldest( direction );
+
+        if ( r->deadline <= lib::rdtsc() ) {
+          expired++;
+        }
+        else {
+          // continue the sweep, wrap around at the end of the disk
+          r = sorted[ direction ].head;
+
+          while ( r && r->lba < position[ direction ] )
+            r = r->next;
+
+          if ( r == 0 )
+            r = sorted[ direction ].head;
+        }
+
+        batch = 0;
+      }
+
+      cursor = r->next;
+      sorted[ r->direction ].remove( r );
+
+      position[ r->direction ] = r->lba + r->length;
+      batch++;
+
+      return r;
+    }
+
+    const char* DeadlineScheduler::name() {
+      return "deadline";
+    }
+
+  }
+
+}
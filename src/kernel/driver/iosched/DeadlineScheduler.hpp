@@ -0,0 +1,76 @@
+/**
+ * DeadlineScheduler.hpp
+ *
+ * @since 19.10.2026
+ * @author Arne Simon => email::[arne_simon@gmx.de]
+ */
+
+#ifndef KERNEL_DRIVER_DEADLINESCHEDULER_HPP_
+#define KERNEL_DRIVER_DEADLINESCHEDULER_HPP_
+
+#include <cpp.hpp>
+#include <kernel/driver/iosched/IOScheduler.hpp>
+
+namespace kernel {
+
+  namespace driver {
+
+    /**
+     * An elevator which bounds how long a request waits.
+     *
+     * Reads and writes are queued apart, sorted by sector. The requests
+     * go out in batches of up to FifoBatch, each batch sweeps upwards from
+     * where the last one of its direction stopped, so the head moves in one
+     * direction and wraps around. Reads are preferred, because a thread
+     * usually waits for them, but after WritesStarved read batches with
+     * writes pending a write batch follows.
+     *
+     * Every request gets a deadline, ReadExpire or WriteExpire after its
+     * submission. A batch starts at the oldest request of its direction
+     * instead of the sweep position once that one has expired, so no
+     * request starves behind a stream of closer ones.
+     *
+     * A new request is merged into a queued chain of its direction it
+     * continues or precedes.
+     *
+     * @since 19.10.2026
+     * @author Arne Simon => email::[arne_simon@gmx.de]
+     */
+    class DeadlineScheduler: public IOScheduler {
+      public:
+        static const uint32 ReadExpire = 500; ///< Milliseconds.
+        static const uint32 WriteExpire = 5000; ///< Milliseconds.
+        static const uint32 FifoBatch = 16;
+        static const uint32 WritesStarved = 2;
+
+      protected:
+        Queue sorted[ 2 ]; ///< Per direction.
+        uint64 position[ 2 ]; ///< Per direction, the sector the last batch stopped at.
+        Request* cursor; ///< The next request of the current batch.
+        uint32 batch; ///< Requests of the current batch so far.
+        uint32 starved; ///< Read batches while writes were pending.
+
+        void enqueue( Request* r );
+
+        bool merge( Request* r );
+
+        Request* pick();
+
+        /**
+         * @return The request with the earliest deadline of a direction.
+         */
+        Request* oldest( uint8 direction );
+
+      public:
+        uint32 expired; ///< Batches started at an expired request.
+
+        DeadlineScheduler();
+
+        const char* name();
+    };
+
+  }
+
+}
+
+#endif /* KERNEL_DRIVER_DEADLINESCHEDULER_HPP_ */
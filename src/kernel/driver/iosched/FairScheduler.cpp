@@ -0,0 +1,84 @@
+/**
+ * FairScheduler.cpp
+ *
+ * @since 19.10.2026
+ * @author Arne Simon => email::[arne_simon@gmx.de]
+ */
+
+#include "FairScheduler.hpp"
+#include <kernel/Process.hpp>
+
+namespace kernel {
+
+  namespace driver {
+
+    FairScheduler::Owner::Owner()
+        : position( 0 ) {
+    }
+
+    FairScheduler::FairScheduler()
+        : current( 0 ), served( 0 ) {
+    }
+
+    uint32 FairScheduler::hash( Request* r ) {
+      // the ids are handed out in a row, so neighbouring processes get their own queues
+      return r->owner ? r->owner->_id % Queues : 0;
+    }
+
+    void FairScheduler::enqueue( Request* r ) {
+      owners[ hash( r ) ].queue.insert( r );
+    }
+
+    bool FairScheduler::merge( Request* r ) {
+      for ( uint32 k = 0; k < Queues; ++k ) {
+        Queue& q = owners[ k ].queue;
+
+        for ( Request* i = q.head; i && i->lba <= r->lba + r->length; i = i->next ) {
+          if ( backMerge( i, r ) )
+            return true;
+
+          if ( frontMerge( i, r ) ) {
+            q.replace( i, r );
+            return true;
+          }
+        }
+      }
+
+      return false;
+    }
+
+    IOScheduler::Request* FairScheduler::pick() {
+      for ( uint32 k = 0; k <= Queues; ++k ) {
+        Owner& o = owners[ current ];
+
+        if ( o.queue.head && served < Quantum ) {
+          Request* r = o.queue.head;
+
+          while ( r && r->lba < o.position )
+            r = r->next;
+
+          if ( r == 0 )
+            r = o.queue.head;
+
+          o.queue.remove( r );
+          o.position = r->lba + r->length;
+          served++;
+
+          return r;
+        }
+
+        // the turn passes on
+        current = ( current + 1 ) % Queues;
+        served = 0;
+      }
+
+      return 0;
+    }
+
+    const char* FairScheduler::name() {
+      return "fair";
+    }
+
+  }
+
+}
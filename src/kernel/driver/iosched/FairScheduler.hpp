@@ -0,0 +1,72 @@
+/**
+ * FairScheduler.hpp
+ *
+ * @since 19.10.2026
+ * @author Arne Simon => email::[arne_simon@gmx.de]
+ */
+
+#ifndef KERNEL_DRIVER_FAIRSCHEDULER_HPP_
+#define KERNEL_DRIVER_FAIRSCHEDULER_HPP_
+
+#include <cpp.hpp>
+#include <kernel/driver/iosched/IOScheduler.hpp>
+
+namespace kernel {
+
+  namespace driver {
+
+    /**
+     * Shares the disk between the processes.
+     *
+     * The requests are queued per submitting process, sorted by sector.
+     * The queues are served round robin, each one for up to Quantum
+     * chains per turn, so a process streaming a large file can not push
+     * the single reads of the others far back. Within its turn a queue is
+     * swept upwards from where its last turn stopped.
+     *
+     * The processes go to one of Queues queues by their id, processes
+     * which share a queue share its turn. The kernel itself has queue 0.
+     *
+     * Boot with elevator=fair on the kernel command line to use it.
+     *
+     * Merging works across the queues, the chain counts for the queue its
+     * head is in.
+     *
+     * @since 19.10.2026
+     * @author Arne Simon => email::[arne_simon@gmx.de]
+     */
+    class FairScheduler: public IOScheduler {
+      public:
+        static const uint32 Queues = 8;
+        static const uint32 Quantum = 8;
+
+      protected:
+        struct Owner {
+            Queue queue;
+            uint64 position; ///< The sector the last turn stopped at.
+
+            Owner();
+        } owners[ Queues ];
+
+        uint32 current; ///< The queue whose turn it is.
+        uint32 served; ///< Chains of the current turn so far.
+
+        uint32 hash( Request* r );
+
+        void enqueue( Request* r );
+
+        bool merge( Request* r );
+
+        Request* pick();
+
+      public:
+        FairScheduler();
+
+        const char* name();
+    };
+
+  }
+
+}
+
+#endif /* KERNEL_DRIVER_FAIRSCHEDULER_HPP_ */
@@ -0,0 +1,211 @@
+/**
+ * IOScheduler.cpp
+ *
+ * @since 19.10.2026
+ * @author Arne Simon => email::[arne_simon@gmx.de]
+ */
+
+#include "IOScheduler.hpp"
+#include <kernel/driver/iosched/NoopScheduler.hpp>
+#include <kernel/driver/iosched/DeadlineScheduler.hpp>
+#include <kernel/driver/iosched/FairScheduler.hpp>
+#include <lib/std.hpp>
+
+namespace kernel {
+
+  namespace driver {
+
+    template< class T >
+    static IOScheduler* make() {
+      return new T();
+    }
+
+    IOScheduler* (*IOScheduler::factory)() = &make< DeadlineScheduler >;
+
+    void IOScheduler::choose( const char* name ) {
+      if ( lib::strstr( name, "noop" ) == name )
+        factory = &make< NoopScheduler >;
+      else if ( lib::strstr( name, "deadline" ) == name )
+        factory = &make< DeadlineScheduler >;
+      else if ( lib::strstr( name, "fair" ) == name )
+        factory = &make< FairScheduler >;
+    }
+
+    IOScheduler* IOScheduler::create() {
+      return factory();
+    }
+
+    IOScheduler::Queue::Queue()
+        : head( 0 ), tail( 0 ) {
+    }
+
+    void IOScheduler::Queue::append( Request* r ) {
+      r->next = 0;
+      r->prev = tail;
+
+      if ( tail )
+        tail->next = r;
+      else
+        head = r;
+
+      tail = r;
+    }
+
+    void IOScheduler::Queue::insert( Request* r ) {
+      Request* q = tail;
+
+      // new requests tend to go behind the others, search from the end
+      while ( q && q->lba > r->lba )
+        q = q->prev;
+
+      r->prev = q;
+      r->next = q ? q->next : head;
+
+      if ( r->next )
+        r->next->prev = r;
+      else
+        tail = r;
+
+      if ( q )
+        q->next = r;
+      else
+        head = r;
+    }
+
+    void IOScheduler::Queue::remove( Request* r ) {
+      if ( r->prev )
+        r->prev->next = r->next;
+      else
+        head = r->next;
+
+      if ( r->next )
+        r->next->prev = r->prev;
+      else
+        tail = r->prev;
+
+      r->next = 0;
+      r->prev = 0;
+    }
+
+    void IOScheduler::Queue::replace( Request* q, Request* r ) {
+      r->next = q->next;
+      r->prev = q->prev;
+
+      if ( r->prev )
+        r->prev->next = r;
+      else
+        head = r;
+
+      if ( r->next )
+        r->next->prev = r;
+      else
+        tail = r;
+
+      q->next = 0;
+      q->prev = 0;
+    }
+
+    IOScheduler::IOScheduler()
+        : back_merges( 0 ), front_merges( 0 ), dispatched( 0 ), sectors( 0 ), queued( 0 ), device( 0 ), held( 0 ) {
+    }
+
+    void IOScheduler::attach( BlockDevice* dev ) {
+      device = dev;
+    }
+
+    bool IOScheduler::mergeable( Request* q, Request* r ) {
+      return q->direction == r->direction && not ( q->flags | r->flags ) && q->length + r->length <= device->max_sectors
+          && q->pages + r->pages <= device->max_pages;
+    }
+
+    bool IOScheduler::backMerge( Request* q, Request* r ) {
+      if ( q->lba + q->length != r->lba || not mergeable( q, r ) )
+        return false;
+
+      Request* last = q;
+
+      while ( last->merged )
+        last = last->merged;
+
+      last->merged = r;
+      q->length += r->length;
+      q->pages += r->pages;
+
+      back_merges++;
+
+      return true;
+    }
+
+    bool IOScheduler::frontMerge( Request* q, Request* r ) {
+      if ( r->lba + r->length != q->lba || not mergeable( q, r ) )
+        return false;
+
+      Request* last = r;
+
+      while ( last->merged )
+        last = last->merged;
+
+      last->merged = q;
+      r->length += q->length;
+      r->pages += q->pages;
+
+      // the chain keeps the earlier deadline
+      if ( q->deadline < r->deadline )
+        r->deadline = q->deadline;
+
+      front_merges++;
+
+      return true;
+    }
+
+    void IOScheduler::add( Request* r ) {
+      if ( merge( r ) )
+        return;
+
+      enqueue( r );
+      queued++;
+    }
+
+    IOScheduler::Request* IOScheduler::next() {
+      Request* r = held;
+
+      if ( r )
+        held = 0;
+      else if ( queued ) {
+        r = pick();
+
+        if ( r )
+          queued--;
+      }
+
+      return r;
+    }
+
+    void IOScheduler::requeue( Request* r ) {
+      held = r;
+    }
+
+    void IOScheduler::started( uint32 length ) {
+      dispatched++;
+      sectors += length;
+    }
+
+    uint32 IOScheduler::average() {
+      uint64 s = sectors;
+      uint32 d = dispatched;
+
+      // keep the division 32 bit, the kernel has no 64 bit one
+      while ( s >> 32 ) {
+        s >>= 1;
+        d >>= 1;
+      }
+
+      if ( d == 0 )
+        return 0;
+
+      return ( uint32 ) s / d * BlockDevice::SectorSize;
+    }
+
+  }
+
+}
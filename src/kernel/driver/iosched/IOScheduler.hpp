@@ -0,0 +1,174 @@
+/**
+ * IOScheduler.hpp
+ *
+ * @since 19.10.2026
+ * @author Arne Simon => email::[arne_simon@gmx.de]
+ */
+
+#ifndef KERNEL_DRIVER_IOSCHEDULER_HPP_
+#define KERNEL_DRIVER_IOSCHEDULER_HPP_
+
+#include <cpp.hpp>
+#include <kernel/driver/BlockDevice.hpp>
+
+namespace kernel {
+
+  namespace driver {
+
+    /**
+     * Decides in which order the queued requests of a BlockDevice go to
+     * the driver, and merges adjacent ones into longer transfers.
+     *
+     * The device calls add() for every submitted request and next() when
+     * the driver has room, both with its queue lock held and interrupts
+     * off. A request the driver could not take goes back with requeue()
+     * and is handed out first again. Implementations only provide the
+     * order in pick(), the merging helpers and the statistics are shared.
+     *
+     * The requests are queued in intrusive lists through next and prev, so
+     * no allocation happens in interrupt context.
+     *
+     * @section ioschedchoice Choice
+     * A rotating drive starts with create(), the DeadlineScheduler unless
+     * choose() picked another one at boot, e.g. for elevator=fair on the
+     * kernel command line. Drives without seeks, like a RAM disk, keep the
+     * NoopScheduler. BlockDevice::elevator() switches a single device.
+     *
+     * @section ioschedstats Statistics
+     * @code
+     * IOScheduler* s = drive->elevator();
+     *
+     * system->video << s->name() << " merges " << s->back_merges << "/" << s->front_merges;
+     * system->video << " average " << s->average() << " Byte\n";
+     * @endcode
+     *
+     * @since 19.10.2026
+     * @author Arne Simon => email::[arne_simon@gmx.de]
+     */
+    class IOScheduler {
+      public:
+        typedef BlockDevice::Request Request;
+
+        /**
+         * A doubly linked list of chain heads.
+         */
+        struct Queue {
+            Request* head;
+            Request* tail;
+
+            Queue();
+
+            void append( Request* r );
+
+            /**
+             * Inserts in ascending sector order, behind equal ones.
+             */
+            void insert( Request* r );
+
+            void remove( Request* r );
+
+            /**
+             * Puts r at the place of q.
+             */
+            void replace( Request* q, Request* r );
+        };
+
+        uint32 back_merges; ///< Requests appended to a queued chain.
+        uint32 front_merges; ///< Requests put in front of a queued chain.
+        uint32 dispatched; ///< Chains started by the driver.
+        uint64 sectors; ///< Sectors of the dispatched chains.
+        uint32 queued; ///< Chains waiting in the scheduler.
+
+      protected:
+        static IOScheduler* (*factory)(); ///< Creates the chosen scheduler.
+
+        BlockDevice* device;
+        Request* held; ///< Given back by requeue().
+
+        /**
+         * @return True if q and r may form one chain within the limits of the device.
+         */
+        bool mergeable( Request* q, Request* r );
+
+        /**
+         * Appends r to the chain of q if r continues it.
+         */
+        bool backMerge( Request* q, Request* r );
+
+        /**
+         * Puts r in front of the chain of q if r precedes it. The caller
+         * replaces q by r in its lists.
+         */
+        bool frontMerge( Request* q, Request* r );
+
+        /**
+         * Queues a request which could not be merged.
+         */
+        virtual void enqueue( Request* r ) = 0;
+
+        /**
+         * Tries to merge a new request into the queued ones.
+         */
+        virtual bool merge( Request* r ) = 0;
+
+        /**
+         * Takes the next chain out of the queues.
+         */
+        virtual Request* pick() = 0;
+
+      public:
+        IOScheduler();
+
+        /**
+         * Binds the scheduler to its device, which owns it.
+         */
+        void attach( BlockDevice* dev );
+
+        /**
+         * Merges or queues a submitted request.
+         */
+        void add( Request* r );
+
+        /**
+         * @return The next chain for the driver, null if none is queued.
+         */
+        Request* next();
+
+        /**
+         * Gives back the chain next() returned, the driver was full.
+         */
+        void requeue( Request* r );
+
+        /**
+         * Counts a chain the driver took.
+         */
+        void started( uint32 length );
+
+        /**
+         * @return The average size of the dispatched chains in bytes.
+         */
+        uint32 average();
+
+        virtual const char* name() = 0;
+
+        /**
+         * Chooses the scheduler of the devices created from now on.
+         *
+         * @param name Starts with "noop", "deadline" or "fair", anything else is ignored.
+         */
+        static void choose( const char* name );
+
+        /**
+         * @return A new instance of the chosen scheduler.
+         */
+        static IOScheduler* create();
+
+        virtual ~IOScheduler() {
+        }
+    };
+
+  }
+
+}
+
+#endif /* KERNEL_DRIVER_IOSCHEDULER_HPP_ */
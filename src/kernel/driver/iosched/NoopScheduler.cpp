@@ -0,0 +1,37 @@
+/**
+ * NoopScheduler.cpp
+ *
+ * @since 19.10.2026
+ * @author Arne Simon => email::[arne_simon@gmx.de]
+ */
+
+#include "NoopScheduler.hpp"
+
+namespace kernel {
+
+  namespace driver {
+
+    void NoopScheduler::enqueue( Request* r ) {
+      fifo.append( r );
+    }
+
+    bool NoopScheduler::merge( Request* r ) {
+      return fifo.tail && backMerge( fifo.tail, r );
+    }
+
+    IOScheduler::Request* NoopScheduler::pick() {
+      Request* r = fifo.head;
+
+      if ( r )
+        fifo.remove( r );
+
+      return r;
+    }
+
+    const char* NoopScheduler::name() {
+      return "noop";
+    }
+
+  }
+
+}
@@ -0,0 +1,47 @@
+/**
+ * NoopScheduler.hpp
+ *
+ * @since 19.10.2026
+ * @author Arne Simon => email::[arne_simon@gmx.de]
+ */
+
+#ifndef KERNEL_DRIVER_NOOPSCHEDULER_HPP_
+#define KERNEL_DRIVER_NOOPSCHEDULER_HPP_
+
+#include <cpp.hpp>
+#include <kernel/driver/iosched/IOScheduler.hpp>
+
+namespace kernel {
+
+  namespace driver {
+
+    /**
+     * First come, first served.
+     *
+     * Only a request continuing the last queued one is merged, which
+     * catches a sequential stream at the cost of nothing. For devices
+     * without seek times, or with a queue of their own which reorders
+     * anyway.
+     *
+     * @since 19.10.2026
+     * @author Arne Simon => email::[arne_simon@gmx.de]
+     */
+    class NoopScheduler: public IOScheduler {
+      protected:
+        Queue fifo;
+
+        void enqueue( Request* r );
+
+        bool merge( Request* r );
+
+        Request* pick();
+
+      public:
+        const char* name();
+    };
+
+  }
+
+}
+
+#endif /* KERNEL_DRIVER_NOOPSCHEDULER_HPP_ */
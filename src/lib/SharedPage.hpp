@@ -0,0 +1,159 @@
+/**
+ * SharedPage.hpp
+ *
+ * @since 19.10.2026
+ * @author Arne Simon => email::[arne_simon@gmx.de]
+ */
+
+#ifndef LIB_SHAREDPAGE_HPP_
+#define LIB_SHAREDPAGE_HPP_
+
+#include <cpp.hpp>
+#include <lib/std.hpp>
+#include <lib/sync/SeqLock.hpp>
+
+namespace lib {
+
+  /**
+   * Kernel data which every process can read without a system call.
+   *
+   * The kernel owns one page with this layout and maps it read only at
+   * Address into every process. The dispatcher updates it under the
+   * SeqLock, readers copy the fields and retry if they raced with it.
+   *
+   * The monotonic clock is the time at the last update plus the TSC cycles
+   * since then, scaled with the calibrated TSC frequency:
+   * @code
+   * ns = clock + ( ( rdtsc() - tsc ) * tsc_mult ) >> Shift
+   * @endcode
+   *
+   * The current cpu is the limit of the segment CPUSelector, which every
+   * cpu loads with its own GDT, so lsl reads it in ring 3.
+   *
+   * @section sharedpagebenchmark Clock Benchmark
+   * kernel::Benchmark::clock() compares reading the clock from the page
+   * with an empty system call.
+   *
+   * @attention Processes only read the page, the writing methods are for the kernel.
+   *
+   * @since 19.10.2026
+   * @author Arne Simon => email::[arne_simon@gmx.de]
+   */
+  class SharedPage {
+    public:
+      static const uint32 Address = 0xbffff000; ///< The virtual address of the page in every process.
+      static const uint16 CPUSelector = 0x30 | 3; ///< The segment whose limit is the cpu number.
+      static const uint32 Shift = 22; ///< The fixed point shift of tsc_mult.
+
+      sync::SeqLock lock;
+      uint64 tick; ///< The number of dispatcher runs, the scheduler tick.
+      uint64 tsc; ///< The time stamp counter at the last update.
+      uint64 clock; ///< The monotonic clock in nanoseconds at the last update.
+      uint32 tsc_khz; ///< The calibrated TSC frequency, 0 if unknown.
+      uint32 tsc_mult; ///< Nanoseconds per cycle, shifted left by Shift.
+      uint32 cpus; ///< The number of running cpus.
+
+      /**
+       * @return The page as mapped into the calling process.
+       */
+      static const SharedPage* get() {
+        return ( const SharedPage* ) Address;
+      }
+
+      /**
+       * @return The cpu the caller runs on.
+       */
+      static uint32 cpu() {
+        uint32 limit;
+
+        asm volatile("lsl %1, %0": "=r"(limit): "r"(( uint32 ) CPUSelector));
+
+        return limit;
+      }
+
+      /**
+       * Converts TSC cycles into nanoseconds.
+       *
+       * The cycles are scaled in two 32 bit halves, so the product does not
+       * overflow even for a TSC running for years.
+       */
+      static uint64 scale( uint64 cycles, uint32 mult ) {
+        uint64 low = ( ( cycles & 0xffffffff ) * mult ) >> Shift;
+        uint64 high = ( ( cycles >> 32 ) * mult ) << ( 32 - Shift );
+
+        return low + high;
+      }
+
+      /**
+       * @return The monotonic clock in nanoseconds since boot.
+       */
+      uint64 now() const {
+        uint32 seq;
+        uint64 c, t;
+        uint32 m;
+
+        do {
+          seq = lock.readBegin();
+          c = clock;
+          t = tsc;
+          m = tsc_mult;
+        } while ( lock.readRetry( seq ) );
+
+        return c + scale( rdtsc() - t, m );
+      }
+
+      /**
+       * @return The scheduler tick.
+       */
+      uint64 ticks() const {
+        uint32 seq;
+        uint64 t;
+
+        do {
+          seq = lock.readBegin();
+          t = tick;
+        } while ( lock.readRetry( seq ) );
+
+        return t;
+      }
+
+      //--- Kernel ---
+
+      /**
+       * Sets the TSC frequency and restarts the clock at the current TSC.
+       *
+       * @param khz The TSC frequency, has to be above 1 MHz.
+       */
+      void calibrate( uint32 khz ) {
+        uint64 n = ( uint64 ) 1000000 << Shift; // nanoseconds per millisecond
+        uint32 mult, rest;
+
+        // a 64 by 32 bit division without libgcc, the quotient fits 32 bits for khz > 1000
+        asm volatile("divl %4": "=a"(mult), "=d"(rest): "0"(( uint32 ) n), "1"(( uint32 ) ( n >> 32 )), "r"(khz));
+
+        lock.writeEnter();
+        tsc = rdtsc();
+        tsc_khz = khz;
+        tsc_mult = mult;
+        lock.writeLeave();
+      }
+
+      /**
+       * Advances the clock and the scheduler tick, called by the dispatcher.
+       */
+      void update() {
+        lock.writeEnter();
+
+        uint64 t = rdtsc();
+
+        clock += scale( t - tsc, tsc_mult );
+        tsc = t;
+        tick++;
+
+        lock.writeLeave();
+      }
+  };
+
+}
+
+#endif /* LIB_SHAREDPAGE_HPP_ */
@@ -0,0 +1,108 @@
+/**
+ * Syscall.hpp
+ *
+ * @since 19.10.2026
+ * @author Arne Simon => email::[arne_simon@gmx.de]
+ */
+
+#ifndef LIB_SYSCALL_HPP_
+#define LIB_SYSCALL_HPP_
+
+#include <cpp.hpp>
+#include <lib/std.hpp>
+
+namespace lib {
+
+  /**
+   * The system call interface for programs running in ring 3.
+   *
+   * ABI:
+   * <ul>
+   *  <li>eax - number of the call, on return the result</li>
+   *  <li>ebx, esi, edi - the arguments</li>
+   *  <li>ecx, edx - clobbered, SYSENTER passes the return stack and address in them</li>
+   * </ul>
+   *
+   * The fast path is SYSENTER/SYSEXIT, on cpus without it the call traps
+   * through the interrupt gate Vector.
+   *
+   * @section syscallbenchmark System Call Benchmark
+   * kernel::Benchmark::clock() measures the round trip of an empty call
+   * through the interrupt gate, SYSEXIT can not return to the kernel.
+   *
+   * @since 19.10.2026
+   * @author Arne Simon => email::[arne_simon@gmx.de]
+   */
+  class Syscall {
+    public:
+      enum Number {
+        Nop, ///< Does nothing, for measurements.
+        Exit, ///< exit( result ), ends the calling thread.
+        Yield, ///< Gives the cpu to the next thread.
+        Write, ///< write( buffer, length ), prints to the console.
+        FutexWait, ///< futex_wait( address, expected ), see kernel::Futex::wait.
+        FutexWake, ///< futex_wake( address, count ), see kernel::Futex::wake.
+        ThreadId, ///< Returns the id of the calling thread.
+        Count
+      };
+
+      static const uint8 Vector = 0x80; ///< The interrupt gate of the slow path.
+
+      /**
+       * @return True if the cpu supports SYSENTER/SYSEXIT.
+       */
+      static bool available() {
+        static int32 sep = -1;
+
+        if ( sep < 0 ) {
+          uint32 a[ 4 ];
+
+          lib::cpuid( 0x01, a );
+
+          // the Pentium Pro reports SEP, but does not have it
+          bool ppro = ( ( a[ 0 ] >> 8 ) & 0xf ) == 6 && ( ( a[ 0 ] >> 4 ) & 0xf ) < 3 && ( a[ 0 ] & 0xf ) < 3;
+
+          sep = ( a[ 3 ] & ( 1 << 11 ) ) && not ppro;
+        }
+
+        return sep;
+      }
+
+      static uint32 fast( uint32 number, uint32 a = 0, uint32 b = 0, uint32 c = 0 ) {
+        uint32 result;
+
+        asm volatile(
+            "movl %%esp, %%ecx;"
+            "movl $1f, %%edx;"
+            "sysenter;"
+            "1:"
+            : "=a"(result)
+            : "a"(number), "b"(a), "S"(b), "D"(c)
+            : "ecx", "edx", "memory");
+
+        return result;
+      }
+
+      static uint32 trap( uint32 number, uint32 a = 0, uint32 b = 0, uint32 c = 0 ) {
+        uint32 result;
+
+        asm volatile(
+            "int $0x80;"
+            : "=a"(result)
+            : "a"(number), "b"(a), "S"(b), "D"(c)
+            : "memory");
+
+        return result;
+      }
+
+      static uint32 call( uint32 number, uint32 a = 0, uint32 b = 0, uint32 c = 0 ) {
+        if ( available() )
+          return fast( number, a, b, c );
+
+        return trap( number, a, b, c );
+      }
+  };
+
+}
+
+#endif /* LIB_SYSCALL_HPP_ */
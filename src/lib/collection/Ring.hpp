@@ -110,22 +110,33 @@ namespace lib {
          * @param t
          */
         void remove( T t ) {
-          if ( _start->data == t ) {
-            _size--;
-            Node* n = _start;
-            _start = n->next;
-            delete n;
+          if ( _start == 0 )
+            return;
+
+          Node* pre = _start;
+
+          // find the node in front of the element, the ring is closed
+          while ( pre->next->data != t ) {
+            pre = pre->next;
+
+            if ( pre == _start )
+              return;
+          }
+
+          Node* n = pre->next;
+          _size--;
+
+          if ( n == pre ) {
+            _start = 0;
           }
           else {
-            Node* pre = _start;
-            for ( Node* i = _start->next; i != _start; i = i->next ) {
-              if ( i->data == t ) {
-                _size--;
-                pre->next = i->next;
-                delete i;
-              }
-            }
+            pre->next = n->next;
+
+            if ( n == _start )
+              _start = n->next;
           }
+
+          delete n;
         }
 
         uint32 size() const {
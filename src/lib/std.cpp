@@ -43,6 +43,20 @@ namespace lib {
     return i;
   }
 
+  const char* strstr( const char* str, const char* word ) {
+    for ( ; *str; ++str ) {
+      uint32 k = 0;
+
+      while ( word[ k ] && str[ k ] == word[ k ] )
+        k++;
+
+      if ( word[ k ] == '\0' )
+        return str;
+    }
+
+    return 0;
+  }
+
   char int2char( uint32 i ) {
     if ( i < 10 )
       return i + '0';
@@ -201,6 +215,16 @@ namespace lib {
     return ret & ( 1 << 9 ) ? true : false;
   }
 
+  bool interrupts() {
+    uint32 flags;
+    asm volatile(
+        "pushfl;"
+        "popl %0;"
+        : "=r"(flags)
+    );
+    return flags & ( 1 << 9 ) ? true : false;
+  }
+
   void* alloc( uint32 size ) {
     return system->virtual_memory.alloc( size );
   }
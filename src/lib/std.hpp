@@ -20,6 +20,15 @@ namespace lib {
     */
    uint32 strlen( const char* str );
 
+   /**
+    * Finds a word in a C-style zero terminated string.
+    *
+    * @param str The string.
+    * @param word The word to look for.
+    * @return The first occurrence of the word in the string, or null.
+    */
+   const char* strstr( const char* str, const char* word );
+
    /**
     * Logarithm of base 2.
     * @param x The value.
@@ -58,6 +67,16 @@ namespace lib {
       asm volatile("wrmsr"::"a"(lo),"d"(hi),"c"(msr));
    }
 
+   /**
+    * Reads the time stamp counter of the cpu.
+    * @return The cycles since the cpu reset.
+    */
+   inline uint64 rdtsc() {
+      uint32 lo, hi;
+      asm volatile("rdtsc":"=a"(lo),"=d"(hi));
+      return ( ( uint64 ) hi << 32 ) | lo;
+   }
+
    inline uint8 from_bcd( uint8 bcd ) {
       return ( bcd & 0x0f ) + ( bcd >> 4 ) * 10;
    }
@@ -93,6 +112,11 @@ namespace lib {
     */
    bool cli();
 
+   /**
+    * @return True if interrupts are enabled.
+    */
+   bool interrupts();
+
    template< class T > T min( T a, T b ) {
       return a < b ? a : b;
    }
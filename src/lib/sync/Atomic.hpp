@@ -0,0 +1,106 @@
+/**
+ * Atomic.hpp
+ *
+ * @since 19.10.2026
+ * @author Arne Simon => email::[arne_simon@gmx.de]
+ */
+
+#ifndef LIB_SYNC_ATOMIC_HPP_
+#define LIB_SYNC_ATOMIC_HPP_
+
+#include <cpp.hpp>
+
+namespace lib {
+
+  namespace sync {
+
+    /**
+     * Atomically stores a value and returns the previous one.
+     *
+     * @note xchg with a memory operand is always locked, no lock prefix needed.
+     */
+    inline uint32 exchange( volatile uint32* ptr, uint32 value ) {
+      asm volatile("xchgl %0, %1" : "=r"(value), "+m"(*ptr) : "0"(value) : "memory");
+      return value;
+    }
+
+    /**
+     * Atomically replaces the value with Desired, if it equals Expected.
+     *
+     * @return The value found before the operation. Equals Expected on success.
+     */
+    inline uint32 compare_exchange( volatile uint32* ptr, uint32 expected, uint32 desired ) {
+      uint32 prev;
+      asm volatile("lock; cmpxchgl %2, %1"
+          : "=a"(prev), "+m"(*ptr)
+          : "r"(desired), "0"(expected)
+          : "memory");
+      return prev;
+    }
+
+    /**
+     * Atomically adds a value.
+     *
+     * @return The value before the addition.
+     */
+    inline uint32 fetch_add( volatile uint32* ptr, uint32 value ) {
+      asm volatile("lock; xaddl %0, %1" : "=r"(value), "+m"(*ptr) : "0"(value) : "memory");
+      return value;
+    }
+
+    /**
+     * Atomically sets bits.
+     *
+     * @return The value before the operation.
+     */
+    inline uint32 fetch_or( volatile uint32* ptr, uint32 value ) {
+      uint32 old;
+
+      do {
+        old = *ptr;
+      } while ( compare_exchange( ptr, old, old | value ) != old );
+
+      return old;
+    }
+
+    /**
+     * Atomically clears the bits not in the mask.
+     *
+     * @return The value before the operation.
+     */
+    inline uint32 fetch_and( volatile uint32* ptr, uint32 value ) {
+      uint32 old;
+
+      do {
+        old = *ptr;
+      } while ( compare_exchange( ptr, old, old & value ) != old );
+
+      return old;
+    }
+
+    /**
+     * Tells the cpu that we are in a spin loop.
+     */
+    inline void relax() {
+      asm volatile("pause" : : : "memory");
+    }
+
+    /**
+     * Orders the stores before the loads after this point, also for devices.
+     */
+    inline void fence() {
+      asm volatile("mfence" : : : "memory");
+    }
+
+    /**
+     * Keeps the compiler from moving memory accesses across this point.
+     */
+    inline void barrier() {
+      asm volatile("" : : : "memory");
+    }
+
+  }
+
+}
+
+#endif /* LIB_SYNC_ATOMIC_HPP_ */
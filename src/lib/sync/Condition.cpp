@@ -0,0 +1,45 @@
+/**
+ * Condition.cpp
+ *
+ * @since 19.10.2026
+ * @author Arne Simon => email::[arne_simon@gmx.de]
+ */
+
+#include "Condition.hpp"
+#include <lib/sync/Futex.hpp>
+#include <lib/sync/Atomic.hpp>
+
+namespace lib {
+
+  namespace sync {
+
+    Condition::Condition() :
+      _sequence( 0 ) {
+    }
+
+    void Condition::wait( Mutex& mutex ) {
+      uint32 seq = _sequence;
+
+      mutex.leave();
+
+      futex_wait( &_sequence, seq );
+
+      mutex.enter();
+    }
+
+    void Condition::signal() {
+      fetch_add( &_sequence, 1 );
+      futex_wake( &_sequence, 1 );
+    }
+
+    void Condition::broadcast() {
+      fetch_add( &_sequence, 1 );
+      futex_wake( &_sequence, WakeAll );
+    }
+
+    Condition::~Condition() {
+    }
+
+  }
+
+}
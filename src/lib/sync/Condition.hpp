@@ -0,0 +1,69 @@
+/**
+ * Condition.hpp
+ *
+ * @since 19.10.2026
+ * @author Arne Simon => email::[arne_simon@gmx.de]
+ */
+
+#ifndef LIB_SYNC_CONDITION_HPP_
+#define LIB_SYNC_CONDITION_HPP_
+
+#include <cpp.hpp>
+#include <lib/sync/Mutex.hpp>
+
+namespace lib {
+
+  namespace sync {
+
+    /**
+     * A condition variable.
+     *
+     * The futex word is a sequence number, which every signal increments, so
+     * a signal between leaving the mutex and going to sleep is not lost.
+     *
+     * @code
+     * mutex.enter();
+     * while ( queue.size() == 0 )
+     *   condition.wait( mutex );
+     * item = queue.pop();
+     * mutex.leave();
+     * @endcode
+     *
+     * @attention Like every condition variable, wait() can return without a
+     *    signal. Always check the predicate in a loop.
+     *
+     * @since 19.10.2026
+     * @author Arne Simon => email::[arne_simon@gmx.de]
+     */
+    class Condition {
+      protected:
+        volatile uint32 _sequence;
+
+      public:
+        Condition();
+
+        /**
+         * Releases the mutex, waits for a signal and acquires the mutex again.
+         *
+         * @param mutex A mutex held by the calling thread.
+         */
+        void wait( Mutex& mutex );
+
+        /**
+         * Wakes one waiting thread.
+         */
+        void signal();
+
+        /**
+         * Wakes all waiting threads.
+         */
+        void broadcast();
+
+        virtual ~Condition();
+    };
+
+  }
+
+}
+
+#endif /* LIB_SYNC_CONDITION_HPP_ */
@@ -0,0 +1,35 @@
+/**
+ * Futex.cpp
+ *
+ * @since 19.10.2026
+ * @author Arne Simon => email::[arne_simon@gmx.de]
+ */
+
+#include "Futex.hpp"
+#include <kernel/Futex.hpp>
+#include <lib/Syscall.hpp>
+
+namespace lib {
+
+  namespace sync {
+
+    bool futex_wait( volatile uint32* address, uint32 expected ) {
+      if ( usermode() )
+        return Syscall::call( Syscall::FutexWait, ( uint32 ) address, expected ) == 1;
+
+      return kernel::Futex::wait( address, expected );
+    }
+
+    uint32 futex_wake( volatile uint32* address, uint32 count ) {
+      if ( usermode() ) {
+        uint32 woken = Syscall::call( Syscall::FutexWake, ( uint32 ) address, count );
+
+        return woken == 0xffffffff ? 0 : woken;
+      }
+
+      return kernel::Futex::wake( address, count );
+    }
+
+  }
+
+}
@@ -0,0 +1,52 @@
+/**
+ * Futex.hpp
+ *
+ * @since 19.10.2026
+ * @author Arne Simon => email::[arne_simon@gmx.de]
+ */
+
+#ifndef LIB_SYNC_FUTEX_HPP_
+#define LIB_SYNC_FUTEX_HPP_
+
+#include <cpp.hpp>
+
+namespace lib {
+
+  namespace sync {
+
+    static const uint32 WakeAll = 0xffffffff; ///< Wakes every waiter.
+
+    /**
+     * @return True if the caller runs in ring 3.
+     */
+    inline bool usermode() {
+      uint32 cs;
+
+      asm volatile("movl %%cs, %0" : "=r"(cs));
+
+      return ( cs & 3 ) == 3;
+    }
+
+    /**
+     * Parks the caller while the word contains the expected value.
+     *
+     * The kernel calls kernel::Futex::wait directly, a program in ring 3
+     * goes through lib::Syscall::FutexWait, so the synchronisation objects
+     * work on both sides of the system call.
+     *
+     * @return False if the word did not contain the expected value.
+     */
+    bool futex_wait( volatile uint32* address, uint32 expected );
+
+    /**
+     * Wakes at most count threads parked on the word.
+     *
+     * @return The number of woken threads.
+     */
+    uint32 futex_wake( volatile uint32* address, uint32 count );
+
+  }
+
+}
+
+#endif /* LIB_SYNC_FUTEX_HPP_ */
@@ -0,0 +1,61 @@
+/**
+ * MCSLock.cpp
+ *
+ * @since 19.10.2026
+ * @author Arne Simon => email::[arne_simon@gmx.de]
+ */
+
+#include "MCSLock.hpp"
+#include <lib/sync/Atomic.hpp>
+#include <lib/std.hpp>
+
+namespace lib {
+
+  namespace sync {
+
+    MCSLock::MCSLock()
+        : _tail( 0 ) {
+    }
+
+    void MCSLock::enter( Node& node ) {
+      node.irq = lib::cli();
+      node.next = 0;
+      node.waiting = 1;
+
+      Node* pre = ( Node* ) exchange( ( volatile uint32* ) &_tail, ( uint32 ) &node );
+
+      if ( pre ) {
+        pre->next = &node;
+
+        while ( node.waiting ) { // spin on our own cache line
+          relax();
+        }
+      }
+    }
+
+    void MCSLock::leave( Node& node ) {
+      bool irq = node.irq;
+
+      if ( node.next == 0 ) {
+        // nobody behind us, try to reset the queue
+        if ( compare_exchange( ( volatile uint32* ) &_tail, ( uint32 ) &node, 0 ) == ( uint32 ) &node ) {
+          if ( irq )
+            lib::sti();
+          return;
+        }
+
+        // a successor swapped the tail but has not linked itself yet
+        while ( node.next == 0 ) {
+          relax();
+        }
+      }
+
+      node.next->waiting = 0;
+
+      if ( irq )
+        lib::sti();
+    }
+
+  }
+
+}
@@ -0,0 +1,68 @@
+/**
+ * MCSLock.hpp
+ *
+ * @since 19.10.2026
+ * @author Arne Simon => email::[arne_simon@gmx.de]
+ */
+
+#ifndef LIB_SYNC_MCSLOCK_HPP_
+#define LIB_SYNC_MCSLOCK_HPP_
+
+#include <cpp.hpp>
+
+namespace lib {
+
+  namespace sync {
+
+    /**
+     * A queue spinlock by Mellor-Crummey and Scott.
+     *
+     * Waiters form a linked list of nodes and every waiter spins on the flag
+     * of its own node. Only the releasing cpu touches the cache line of the
+     * next waiter, so the lock scales with the number of cores where a
+     * TicketLock lets every waiter hammer the same line.
+     *
+     * The node usually lives on the stack of the caller:
+     * @code
+     * lib::sync::MCSLock::Node node;
+     *
+     * lock.enter( node );
+     * // critical section
+     * lock.leave( node );
+     * @endcode
+     *
+     * Like the TicketLock, the interrupts are off while the lock is held.
+     *
+     * @note http://www.cs.rochester.edu/u/scott/papers/1991_TOCS_synch.pdf
+     *
+     * @since 19.10.2026
+     * @author Arne Simon => email::[arne_simon@gmx.de]
+     */
+    class MCSLock {
+      public:
+        struct Node {
+            Node* volatile next;
+            volatile uint32 waiting;
+            bool irq; ///< Interrupt state before enter().
+        };
+
+      protected:
+        Node* volatile _tail;
+
+      public:
+        MCSLock();
+
+        void enter( Node& node );
+
+        void leave( Node& node );
+
+        bool locked() const {
+          return _tail != 0;
+        }
+    };
+
+  }
+
+}
+
+#endif /* LIB_SYNC_MCSLOCK_HPP_ */
@@ -7,60 +7,232 @@
 
 #include "Mutex.hpp"
 #include <kernel/Thread.hpp>
+#include <kernel/Trace.hpp>
 #include <lib/Exception.hpp>
+#include <lib/sync/Atomic.hpp>
+#include <lib/std.hpp>
 
 namespace lib {
 
   namespace sync {
 
     Mutex::Mutex() :
-      _lock( 0 ) {
+      _lock( Free ), _owner( 0 ), _held_next( 0 ), contended( 0 ) {
 
     }
 
-    void Mutex::enter() {
-      uint8 l = 1;
+    void Mutex::own( kernel::Thread* t ) {
+      _owner = t;
+
+      if ( t ) {
+        _held_next = t->mutex;
+        t->mutex = this;
+      }
+    }
+
+    void Mutex::disown() {
+      kernel::Thread* t = _owner;
+
+      _owner = 0;
+
+      if ( t == 0 )
+        return;
+
+      Mutex** i = &t->mutex;
+
+      while ( *i && *i != this ) {
+        i = &( *i )->_held_next;
+      }
+
+      if ( *i )
+        *i = _held_next;
+
+      _held_next = 0;
+    }
+
+    void Mutex::inherit( uint8 priority ) {
+      Mutex* m = this;
+      kernel::Thread* w = 0;
 
-      //kernel::Thread* t = kernel::Thread::current();
+      for ( uint32 depth = 0; m && depth < ChainLimit; ++depth ) {
+        m->_queue.enter();
 
-//      if ( t->mutex == this ) {
-//        Exception::throwing( "mutex is already acquired by this thread!" );
-//      }
-//
-//      if ( t->mutex ) {
-//        Exception::throwing( "the thread has already another mutex acquired!" );
-//      }
-//
-//      t->mutex = this;
+        // the boosted owner moves up in the queue it waits in
+        if ( w && w->blocked_on == m && m->_waiters.remove( w ) )
+          m->_waiters.insert( w );
 
-      // set the lock to one, and retrive previous lock state
-      asm volatile ("xchg %b1, %b0" : "=a"(_lock), "=b"(l): "b"(l), "a"(_lock) );
+        kernel::Thread* o = m->_owner;
 
-      // while locked
-      while ( l ) {
+        if ( o == 0 || o->priority() >= priority ) {
+          m->_queue.leave();
+          break;
+        }
+
+        o->behavior.inherited = priority;
+        w = o;
+        m->_queue.leave();
+
+        m = o->blocked_on;
+      }
+    }
+
+    uint8 Mutex::inherited( kernel::Thread* t ) {
+      uint8 priority = 0;
+
+      for ( Mutex* m = t->mutex; m; m = m->_held_next ) {
+        m->_queue.enter();
+
+        kernel::Thread* w = m->_waiters.first();
+
+        if ( w && w->priority() > priority )
+          priority = w->priority();
+
+        m->_queue.leave();
+      }
+
+      return priority;
+    }
+
+    bool Mutex::spin( kernel::Thread* self ) {
+      for ( uint32 i = 0; i < SpinLimit; ++i ) {
+        if ( _lock == Free && compare_exchange( &_lock, Free, Locked ) == Free ) {
+          own( self );
+          return true;
+        }
+
+        kernel::Thread* o = _owner;
+
+        // spinning only makes sense while the owner works on another cpu
+        if ( o == 0 || o == self || o->mode != kernel::Thread::RUNNING )
+          break;
+
+        relax();
+      }
+
+      return false;
+    }
+
+    void Mutex::wait( kernel::Thread* self ) {
+      bool irq = lib::cli();
+
+      // without a thread or with interrupts off we can not be parked,
+      // but the timer interrupt still dispatches the holder on an int $0x20
+      if ( self == 0 || not irq ) {
+        while ( compare_exchange( &_lock, Free, Locked ) != Free ) {
+          if ( self )
+            kernel::Thread::yield();
+          else
+            relax();
+        }
+        own( self );
+
+        if ( irq )
+          lib::sti();
+        return;
+      }
+
+      _queue.enter();
+
+      while ( true ) {
+        uint32 state = _lock;
+
+        if ( state == Free ) {
+          if ( compare_exchange( &_lock, Free, Locked ) == Free ) {
+            own( self );
+            _queue.leave();
+            lib::sti();
+            return;
+          }
+        }
+        else if ( state == Waiters || compare_exchange( &_lock, Locked, Waiters ) == Locked ) {
+          break; // leave() will see the waiter flag and take the slow path
+        }
+      }
+
+      _waiters.insert( self );
+      self->blocked_on = this;
+      self->mode = kernel::Thread::BLOCKED;
+
+      _queue.leave();
+
+      inherit( self->priority() );
+
+      // leave() hands the mutex directly over, when we run again we own it.
+      do {
         kernel::Thread::yield();
+      } while ( self->mode == kernel::Thread::BLOCKED );
+
+      lib::sti();
+    }
+
+    void Mutex::wake() {
+      _queue.enter();
+
+      kernel::Thread* t = _waiters.pop();
+
+      if ( t ) {
+        t->blocked_on = 0;
+        own( t ); // direct handoff, the mutex is never free in between
+
+        if ( _waiters.empty() )
+          _lock = Locked;
+        else if ( _waiters.first()->priority() > t->behavior.inherited )
+          t->behavior.inherited = _waiters.first()->priority();
+
+        t->wakeup();
+      }
+      else {
+        _lock = Free;
+      }
+
+      _queue.leave();
+    }
 
-        asm volatile ("xchg %b1, %b0" : "=a"(_lock), "=b"(l): "b"(l), "a"(_lock) );
-        // get lock state
+    void Mutex::enter() {
+      if ( compare_exchange( &_lock, Free, Locked ) == Free ) {
+        own( kernel::Thread::current() );
+        return;
+      }
+
+      fetch_add( &contended, 1 );
+      kernel::Trace::log( kernel::Trace::Contended, kernel::Trace::MutexWait, ( uint32 ) this );
+
+      kernel::Thread* self = kernel::Thread::current();
+
+      if ( self && _owner == self ) {
+        Exception::throwing( "mutex is already acquired by this thread!" );
+      }
+
+      if ( not spin( self ) ) {
+        wait( self );
       }
     }
 
+    bool Mutex::tryEnter() {
+      if ( compare_exchange( &_lock, Free, Locked ) == Free ) {
+        own( kernel::Thread::current() );
+        return true;
+      }
+
+      return false;
+    }
+
     void Mutex::leave() {
-//      kernel::Thread* t = kernel::Thread::current();
-//
-//      if ( t->mutex ) {
-//        if ( t->mutex == this ) {
-//          t->mutex = 0;
-//        }
-//        else {
-//          Exception::throwing( "the thread tries to free a mutex he has not acquired!" );
-//        }
-//      }
-//      else {
-//        Exception::throwing( "the thread has no mutex acquired but tries to free one!" );
-//      }
-
-      asm volatile ("xchg %b1, %b0" : "=a"(_lock) : "b"(0), "a"(_lock) );
+      if ( _lock == Free ) {
+        Exception::throwing( "the thread has no mutex acquired but tries to free one!" );
+      }
+
+      kernel::Thread* self = _owner;
+
+      disown();
+
+      if ( compare_exchange( &_lock, Locked, Free ) != Locked ) {
+        wake();
+      }
+
+      // the boost ends with the mutex, the other held mutexes may keep one
+      if ( self && self->behavior.inherited )
+        self->behavior.inherited = inherited( self );
     }
 
     Mutex::~Mutex() {
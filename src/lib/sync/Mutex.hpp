@@ -9,6 +9,12 @@
 #define MUTEX_HPP_
 
 #include <cpp.hpp>
+#include <lib/sync/WaitQueue.hpp>
+#include <lib/sync/TicketLock.hpp>
+
+namespace kernel {
+  class Thread;
+}
 
 namespace lib {
 
@@ -17,20 +23,104 @@ namespace lib {
     /**
      * Mutual Exclusion.
      *
+     * An uncontended enter() or leave() is a single locked cmpxchg.
+     *
+     * If the mutex is held, the caller spins for a short while as long as the
+     * owner is running on a cpu, because short critical sections are over
+     * before a context switch would be. Otherwise the caller is parked BLOCKED
+     * on the wait queue of the mutex and does not get any cpu time until
+     * leave() hands the mutex directly over to it.
+     *
+     * Before the scheduler is up and in interrupt context nobody can be
+     * parked, there the mutex falls back to plain spinning.
+     *
+     * @section mutexinheritance Priority Inheritance
+     * The waiters are queued by their priority. A parked thread lends its
+     * priority to the owner, and if the owner itself waits on another mutex,
+     * to that owner too, up to ChainLimit mutexes deep. When the owner
+     * leaves, its inherited priority drops to the highest waiter of the
+     * mutexes it still holds.
+     *
+     * @section mutexbenchmark Contention Benchmark
+     * kernel::Benchmark::contention() lets four threads hammer one mutex and
+     * prints the contended of all acquisitions and the cycles per enter().
+     *
      * @since 09.07.2010
+     * @date 19.10.2026
      * @author Arne Simon => email::[arne_simon@gmx.de]
      */
     class Mutex {
       protected:
-        uint8 _lock;
+        static const uint32 Free = 0;
+        static const uint32 Locked = 1;
+        static const uint32 Waiters = 2; ///< Locked and at least one thread is parked.
+
+        static const uint32 SpinLimit = 100; ///< Maximal spin rounds before a thread gets parked.
+        static const uint32 ChainLimit = 8; ///< Maximal depth of a priority inheritance chain.
+
+        volatile uint32 _lock;
+        kernel::Thread* volatile _owner;
+        TicketLock _queue; ///< Protects the wait queue.
+        WaitQueue _waiters;
+        Mutex* _held_next; ///< The next mutex held by the same owner.
+
+        /**
+         * Makes the thread the owner and links the mutex into its held mutexes.
+         */
+        void own( kernel::Thread* t );
+
+        /**
+         * Unlinks the mutex from the held mutexes of its owner.
+         */
+        void disown();
+
+        /**
+         * Lends the priority along the chain of owners.
+         */
+        void inherit( uint8 priority );
+
+        /**
+         * @return The highest priority of the threads waiting on mutexes held by the thread.
+         */
+        static uint8 inherited( kernel::Thread* t );
+
+        /**
+         * Spins as long as the owner is on a cpu.
+         *
+         * @return True if we got the lock while spinning.
+         */
+        bool spin( kernel::Thread* self );
+
+        /**
+         * Parks the calling thread until the mutex is handed over.
+         */
+        void wait( kernel::Thread* self );
+
+        /**
+         * Hands the mutex over to the first waiter.
+         */
+        void wake();
 
       public:
+        uint32 contended; ///< How often enter() missed the fast path.
+
         Mutex();
 
         void enter();
 
+        /**
+         * Tries to acquire the mutex without waiting.
+         *
+         * @return True if the mutex was acquired.
+         */
+        bool tryEnter();
+
         void leave();
 
+        kernel::Thread* owner() const {
+          return _owner;
+        }
+
         virtual ~Mutex();
     };
 
@@ -0,0 +1,108 @@
+/**
+ * RWLock.cpp
+ *
+ * @since 19.10.2026
+ * @author Arne Simon => email::[arne_simon@gmx.de]
+ */
+
+#include "RWLock.hpp"
+#include <lib/sync/Futex.hpp>
+#include <kernel/Trace.hpp>
+#include <lib/Exception.hpp>
+#include <lib/sync/Atomic.hpp>
+
+namespace lib {
+
+  namespace sync {
+
+    RWLock::RWLock()
+        : _state( 0 ), _writers( 0 ), _sequence( 0 ), _sleepers( 0 ) {
+    }
+
+    void RWLock::wait( uint32 sequence ) {
+      fetch_add( &_sleepers, 1 );
+
+      // the trace buffer is kernel memory
+      if ( not usermode() )
+        kernel::Trace::log( kernel::Trace::Contended, kernel::Trace::RWLockWait, ( uint32 ) this );
+
+      futex_wait( &_sequence, sequence );
+      fetch_add( &_sleepers, ( uint32 ) -1 );
+    }
+
+    void RWLock::release() {
+      fetch_add( &_sequence, 1 );
+
+      if ( _sleepers )
+        futex_wake( &_sequence, WakeAll );
+    }
+
+    bool RWLock::tryReadEnter() {
+      uint32 s = _state;
+
+      while ( not ( s & Writer ) && _writers == 0 ) {
+        uint32 prev = compare_exchange( &_state, s, s + 1 );
+
+        if ( prev == s )
+          return true;
+
+        s = prev;
+      }
+
+      return false;
+    }
+
+    void RWLock::readEnter() {
+      // the sequence is read before the check, a release in between lets wait() return
+      uint32 seq = _sequence;
+
+      while ( not tryReadEnter() ) {
+        wait( seq );
+        seq = _sequence;
+      }
+    }
+
+    void RWLock::readLeave() {
+      uint32 prev = fetch_add( &_state, ( uint32 ) -1 );
+
+      if ( prev == 0 || ( prev & Writer ) ) {
+        Exception::throwing( "RWLock - read leave without a read lock!" );
+      }
+
+      // only a writer waits for the readers
+      if ( prev == 1 && _writers )
+        release();
+    }
+
+    bool RWLock::tryWriteEnter() {
+      return compare_exchange( &_state, 0, Writer ) == 0;
+    }
+
+    void RWLock::writeEnter() {
+      uint32 seq = _sequence;
+
+      if ( tryWriteEnter() )
+        return;
+
+      // from now on no new reader gets in
+      fetch_add( &_writers, 1 );
+
+      while ( not tryWriteEnter() ) {
+        wait( seq );
+        seq = _sequence;
+      }
+
+      fetch_add( &_writers, ( uint32 ) -1 );
+    }
+
+    void RWLock::writeLeave() {
+      if ( exchange( &_state, 0 ) != Writer ) {
+        Exception::throwing( "RWLock - write leave without the write lock!" );
+      }
+
+      release();
+    }
+
+  }
+
+}
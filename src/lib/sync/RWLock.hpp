@@ -0,0 +1,106 @@
+/**
+ * RWLock.hpp
+ *
+ * @since 19.10.2026
+ * @author Arne Simon => email::[arne_simon@gmx.de]
+ */
+
+#ifndef LIB_SYNC_RWLOCK_HPP_
+#define LIB_SYNC_RWLOCK_HPP_
+
+#include <cpp.hpp>
+
+namespace lib {
+
+  namespace sync {
+
+    /**
+     * A writer preferring reader-writer lock.
+     *
+     * Any number of readers hold the lock together, a reader only does one
+     * locked cmpxchg on enter and one locked xadd on leave, so lookups from
+     * several cores do not serialize. A writer holds the lock alone.
+     *
+     * As soon as a writer waits, new readers have to wait too, so a steady
+     * stream of lookups can not starve an update.
+     *
+     * Waiting threads are parked with futex_wait(), which is a system call
+     * in ring 3.
+     *
+     * @code
+     * lib::sync::RWLock lock;
+     *
+     * // lookup
+     * lock.readEnter();
+     * Node* n = map.find( key );
+     * lock.readLeave();
+     *
+     * // update
+     * lock.writeEnter();
+     * map.put( key, value );
+     * lock.writeLeave();
+     * @endcode
+     *
+     * @attention A thread must not read lock recursively, a writer waiting
+     *    between both acquisitions would block it forever.
+     *
+     * @since 19.10.2026
+     * @author Arne Simon => email::[arne_simon@gmx.de]
+     */
+    class RWLock {
+      protected:
+        static const uint32 Writer = 0x80000000; ///< Set in the state while a writer holds the lock.
+
+        volatile uint32 _state; ///< The writer flag or the number of readers.
+        volatile uint32 _writers; ///< Writers waiting for the lock.
+        volatile uint32 _sequence; ///< Counts releases, this is the futex word.
+        volatile uint32 _sleepers; ///< Threads about to be parked or parked.
+
+        /**
+         * Parks the calling thread until the lock is released again.
+         */
+        void wait( uint32 sequence );
+
+        /**
+         * Wakes all parked threads, they recheck the lock themself.
+         */
+        void release();
+
+      public:
+        RWLock();
+
+        void readEnter();
+
+        /**
+         * @return True if the read lock was acquired without waiting.
+         */
+        bool tryReadEnter();
+
+        void readLeave();
+
+        void writeEnter();
+
+        /**
+         * @return True if the write lock was acquired without waiting.
+         */
+        bool tryWriteEnter();
+
+        void writeLeave();
+
+        /**
+         * @return The number of readers holding the lock.
+         */
+        uint32 readers() const {
+          return _state & ~Writer;
+        }
+
+        bool writing() const {
+          return _state & Writer;
+        }
+    };
+
+  }
+
+}
+
+#endif /* LIB_SYNC_RWLOCK_HPP_ */
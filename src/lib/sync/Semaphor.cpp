@@ -6,32 +6,45 @@
  */
 
 #include "Semaphor.hpp"
-#include <kernel/Video.hpp>
+#include <lib/sync/Futex.hpp>
+#include <lib/sync/Atomic.hpp>
 
 namespace lib {
 
   namespace sync {
 
     Semaphor::Semaphor( uint32 Max ) :
-      in( 0 ), comperator( Max ) {
+      _count( Max ), _waiters( 0 ) {
     }
 
-    void Semaphor::enter() {
+    bool Semaphor::tryEnter() {
+      uint32 c = _count;
+
+      while ( c ) {
+        uint32 prev = compare_exchange( &_count, c, c - 1 );
+
+        if ( prev == c )
+          return true;
+
+        c = prev;
+      }
 
-      // increment counter and store old counter in i
-      //asm volatile( "lock inc %0;" : "=a"(in) : "a"(in) );
+      return false;
+    }
 
-      while ( in > comperator ) {
-        // *debug_msgs << id << ":" << ( **core->current )->id << ":" << i << ":" << counter << "|";
-        // invoke schedular!
-        asm volatile( "int $32;" );
-        //asm volatile( "hlt;" );
+    void Semaphor::enter() {
+      while ( not tryEnter() ) {
+        fetch_add( &_waiters, 1 );
+        futex_wait( &_count, 0 ); // sleeps only while no place is free
+        fetch_add( &_waiters, -1 );
       }
     }
 
     void Semaphor::leave() {
-      //  *debug_msgs << id << ":" << ( **core->current )->id << ":" <<  counter << "|";
-      //asm volatile( "lock dec %0;" : "=a"(in) : "a"(in) );
+      fetch_add( &_count, 1 );
+
+      if ( _waiters )
+        futex_wake( &_count, 1 );
     }
 
     Semaphor::~Semaphor() {
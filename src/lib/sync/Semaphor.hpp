@@ -15,18 +15,34 @@ namespace lib {
   namespace sync {
 
     /**
+     * A counting semaphore.
      *
+     * At most Max threads are between enter() and leave() at the same time.
+     * The counter is changed with atomic operations, only a thread that has
+     * to wait or a leave() with parked threads goes through futex_wait() and
+     * futex_wake(), which are system calls in ring 3.
+     *
+     * @since 08.07.2010
+     * @date 19.10.2026
+     * @author Arne Simon => email::[arne_simon@gmx.de]
      */
     class Semaphor {
       private:
-        uint8 in;
-        uint32 comperator;
+        volatile uint32 _count; ///< Free places, this is the futex word.
+        volatile uint32 _waiters; ///< Threads which are about to wait or waiting.
 
       public:
         Semaphor( uint32 Max );
 
         void enter();
 
+        /**
+         * Takes a place without waiting.
+         *
+         * @return True if a place was free.
+         */
+        bool tryEnter();
+
         void leave();
 
         virtual ~Semaphor();
@@ -0,0 +1,107 @@
+/**
+ * SeqLock.hpp
+ *
+ * @since 19.10.2026
+ * @author Arne Simon => email::[arne_simon@gmx.de]
+ */
+
+#ifndef LIB_SYNC_SEQLOCK_HPP_
+#define LIB_SYNC_SEQLOCK_HPP_
+
+#include <cpp.hpp>
+#include <lib/sync/Atomic.hpp>
+#include <lib/sync/TicketLock.hpp>
+
+namespace lib {
+
+  namespace sync {
+
+    /**
+     * A sequence lock for small, often read and seldom written data.
+     *
+     * Readers never write to shared memory, they copy the data and retry if
+     * a writer was active in the meantime. The sequence is odd while a write
+     * is in progress. Writers are serialized by a TicketLock, so writing is
+     * also possible from interrupt context, e.g. the timer tick.
+     *
+     * @code
+     * lib::sync::SeqLock lock;
+     * uint64 ticks;
+     *
+     * // reader
+     * uint32 seq;
+     * uint64 now;
+     *
+     * do {
+     *   seq = lock.readBegin();
+     *   now = ticks;
+     * } while ( lock.readRetry( seq ) );
+     *
+     * // writer
+     * lock.writeEnter();
+     * ticks++;
+     * lock.writeLeave();
+     * @endcode
+     *
+     * @attention Readers must only copy the data, pointers read inside the
+     *    section may already be stale.
+     *
+     * @since 19.10.2026
+     * @author Arne Simon => email::[arne_simon@gmx.de]
+     */
+    class SeqLock {
+      protected:
+        volatile uint32 _sequence;
+        TicketLock _writer;
+
+      public:
+        SeqLock()
+            : _sequence( 0 ) {
+        }
+
+        /**
+         * Starts a read section.
+         *
+         * @return The sequence to pass to readRetry().
+         */
+        uint32 readBegin() const {
+          uint32 seq;
+
+          while ( ( seq = _sequence ) & 1 ) {
+            relax();
+          }
+
+          barrier();
+          return seq;
+        }
+
+        /**
+         * @return True if the data was changed while it was read.
+         */
+        bool readRetry( uint32 seq ) const {
+          barrier();
+          return _sequence != seq;
+        }
+
+        void writeEnter() {
+          _writer.enter();
+          _sequence = _sequence + 1;
+          barrier();
+        }
+
+        void writeLeave() {
+          barrier();
+          _sequence = _sequence + 1;
+          _writer.leave();
+        }
+
+        uint32 sequence() const {
+          return _sequence;
+        }
+    };
+
+  }
+
+}
+
+#endif /* LIB_SYNC_SEQLOCK_HPP_ */
@@ -0,0 +1,58 @@
+/**
+ * TicketLock.cpp
+ *
+ * @since 19.10.2026
+ * @author Arne Simon => email::[arne_simon@gmx.de]
+ */
+
+#include "TicketLock.hpp"
+#include <lib/sync/Atomic.hpp>
+#include <lib/std.hpp>
+
+namespace lib {
+
+  namespace sync {
+
+    TicketLock::TicketLock()
+        : _next( 0 ), _serving( 0 ), _irq( false ) {
+    }
+
+    void TicketLock::enter() {
+      bool irq = lib::cli();
+      uint32 ticket = fetch_add( &_next, 1 );
+
+      while ( _serving != ticket ) {
+        relax();
+      }
+
+      _irq = irq;
+    }
+
+    bool TicketLock::tryEnter() {
+      bool irq = lib::cli();
+      uint32 ticket = _serving;
+
+      if ( compare_exchange( &_next, ticket, ticket + 1 ) == ticket ) {
+        _irq = irq;
+        return true;
+      }
+
+      if ( irq )
+        lib::sti();
+
+      return false;
+    }
+
+    void TicketLock::leave() {
+      bool irq = _irq;
+
+      barrier();
+      _serving = _serving + 1; // only the owner writes, a plain store is enough on x86
+
+      if ( irq )
+        lib::sti();
+    }
+
+  }
+
+}
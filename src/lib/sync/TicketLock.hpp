@@ -0,0 +1,61 @@
+/**
+ * TicketLock.hpp
+ *
+ * @since 19.10.2026
+ * @author Arne Simon => email::[arne_simon@gmx.de]
+ */
+
+#ifndef LIB_SYNC_TICKETLOCK_HPP_
+#define LIB_SYNC_TICKETLOCK_HPP_
+
+#include <cpp.hpp>
+
+namespace lib {
+
+  namespace sync {
+
+    /**
+     * A fair spinlock for short critical sections.
+     *
+     * Every caller draws a ticket and spins until its number is served, so
+     * the lock is granted in arrival order.
+     *
+     * The interrupts are disabled while the lock is held and restored to the
+     * previous state by leave(), so the lock can be used from interrupt
+     * context and by code that is also used from interrupt context.
+     *
+     * @attention Never sleep or yield while holding a spinlock.
+     *
+     * @since 19.10.2026
+     * @author Arne Simon => email::[arne_simon@gmx.de]
+     */
+    class TicketLock {
+      protected:
+        volatile uint32 _next; ///< The next ticket to draw.
+        volatile uint32 _serving; ///< The ticket that holds the lock.
+        bool _irq; ///< Interrupt state of the owner before enter().
+
+      public:
+        TicketLock();
+
+        void enter();
+
+        /**
+         * Acquires the lock, if nobody holds or waits for it.
+         *
+         * @return True if the lock was acquired.
+         */
+        bool tryEnter();
+
+        void leave();
+
+        bool locked() const {
+          return _next != _serving;
+        }
+    };
+
+  }
+
+}
+
+#endif /* LIB_SYNC_TICKETLOCK_HPP_ */
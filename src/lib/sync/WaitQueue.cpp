@@ -0,0 +1,92 @@
+/**
+ * WaitQueue.cpp
+ *
+ * @since 19.10.2026
+ * @author Arne Simon => email::[arne_simon@gmx.de]
+ */
+
+#include "WaitQueue.hpp"
+#include <kernel/Thread.hpp>
+
+namespace lib {
+
+  namespace sync {
+
+    WaitQueue::WaitQueue()
+        : _head( 0 ), _tail( 0 ) {
+    }
+
+    void WaitQueue::push( kernel::Thread* t ) {
+      t->wait_next = 0;
+
+      if ( _tail ) {
+        _tail->wait_next = t;
+      }
+      else {
+        _head = t;
+      }
+
+      _tail = t;
+    }
+
+    void WaitQueue::insert( kernel::Thread* t ) {
+      kernel::Thread* pre = 0;
+      uint8 priority = t->priority();
+
+      for ( kernel::Thread* i = _head; i && i->priority() >= priority; i = i->wait_next ) {
+        pre = i;
+      }
+
+      if ( pre ) {
+        t->wait_next = pre->wait_next;
+        pre->wait_next = t;
+      }
+      else {
+        t->wait_next = _head;
+        _head = t;
+      }
+
+      if ( t->wait_next == 0 )
+        _tail = t;
+    }
+
+    kernel::Thread* WaitQueue::pop() {
+      kernel::Thread* t = _head;
+
+      if ( t ) {
+        _head = t->wait_next;
+
+        if ( _head == 0 )
+          _tail = 0;
+
+        t->wait_next = 0;
+      }
+
+      return t;
+    }
+
+    bool WaitQueue::remove( kernel::Thread* t ) {
+      kernel::Thread* pre = 0;
+
+      for ( kernel::Thread* i = _head; i; i = i->wait_next ) {
+        if ( i == t ) {
+          if ( pre )
+            pre->wait_next = i->wait_next;
+          else
+            _head = i->wait_next;
+
+          if ( _tail == i )
+            _tail = pre;
+
+          i->wait_next = 0;
+          return true;
+        }
+        pre = i;
+      }
+
+      return false;
+    }
+
+  }
+
+}
@@ -0,0 +1,77 @@
+/**
+ * WaitQueue.hpp
+ *
+ * @since 19.10.2026
+ * @author Arne Simon => email::[arne_simon@gmx.de]
+ */
+
+#ifndef LIB_SYNC_WAITQUEUE_HPP_
+#define LIB_SYNC_WAITQUEUE_HPP_
+
+#include <cpp.hpp>
+
+namespace kernel {
+  class Thread;
+}
+
+namespace lib {
+
+  namespace sync {
+
+    /**
+     * A FIFO of blocked threads, optionally ordered by priority.
+     *
+     * The queue is intrusive, it links the threads through Thread::wait_next,
+     * so parking a thread never calls the allocator. This matters, because the
+     * allocator itself is protected by a lock.
+     *
+     * @attention A thread can only wait in one queue at a time.
+     * @attention The queue does no locking, the owner of the queue has to.
+     */
+    class WaitQueue {
+      protected:
+        kernel::Thread* _head;
+        kernel::Thread* _tail;
+
+      public:
+        WaitQueue();
+
+        /**
+         * Appends a thread at the end of the queue.
+         */
+        void push( kernel::Thread* t );
+
+        /**
+         * Inserts a thread behind all threads with the same or a higher
+         * Thread::priority(), so equal threads stay in FIFO order.
+         */
+        void insert( kernel::Thread* t );
+
+        /**
+         * Removes the first thread of the queue.
+         *
+         * @return The thread or null if the queue is empty.
+         */
+        kernel::Thread* pop();
+
+        /**
+         * Removes a thread from anywhere in the queue.
+         *
+         * @return True if the thread was found.
+         */
+        bool remove( kernel::Thread* t );
+
+        kernel::Thread* first() const {
+          return _head;
+        }
+
+        bool empty() const {
+          return _head == 0;
+        }
+    };
+
+  }
+
+}
+
+#endif /* LIB_SYNC_WAITQUEUE_HPP_ */
@@ -22,9 +22,13 @@
 #include <kernel/System.hpp>
 #include <kernel/Thread.hpp>
 #include <kernel/Process.hpp>
+#include <kernel/Benchmark.hpp>
 #include <kernel/driver/Keyboard.hpp>
 #include <kernel/driver/PCI.hpp>
 #include <kernel/driver/ATA.hpp>
+#include <kernel/driver/AHCI.hpp>
+#include <kernel/driver/VirtioBlock.hpp>
+#include <kernel/driver/iosched/IOScheduler.hpp>
 #include <kernel/driver/filesystem/Ext2.hpp>
 #include <kernel/driver/filesystem/MyFS.hpp>
 #include <kernel/driver/fileformat/Elf32.hpp>
@@ -33,6 +37,41 @@
 #include <lib/std.hpp>
 #include <lib/Time.hpp>
 
+kernel::driver::ATA* ide = 0; ///< The IDE controller, null without one.
+
+/**
+ * Mounts the first IDE drive and starts PlatinPython from it.
+ *
+ * Runs in a thread of its own once the boot is done, so the drive
+ * completes its commands by interrupt instead of being polled.
+ */
+void* mount() {
+  kernel::driver::Ext2* ext2 = new kernel::driver::Ext2( &ide->drives[ 0 ], 0 );
+
+  kernel::driver::Ext2::File* r = ext2->root;
+  kernel::driver::fileformat::Elf32 *elf;
+
+  if ( r->hasFiles() ) {
+    lib::File::Files* files = r->files();
+
+    lib::File::Files::KeyIterator* iter = files->keyIterator();
+    lib::String filename( "PlatinPython" );
+
+    while ( *iter ) {
+      if ( ( **iter )->compare( &filename ) == 0 ) {
+        elf = new kernel::driver::fileformat::Elf32( iter->value() );
+        elf->execute();
+      }
+      ++( *iter );
+    }
+
+    delete iter;
+    delete files;
+  }
+
+  return 0;
+}
+
 /**
  * The kernel main and init function.
  *
@@ -69,21 +108,25 @@ void main( MultiBoot* multi_boot ) {
 
   kernel::driver::Keyboard key; // create keyboard driver
 
-  system->isr[ 0x21 ].pushBack( &key ); // adding the keyboard to the interrupt service routines
+  system->attach( 0x21, &key ); // adding the keyboard to the interrupt service routines
+
+  // elevator=noop, deadline or fair on the kernel command line picks the I/O scheduler of the drives
+  const char* elevator = ( multi_boot->flags & 0x04 ) ? lib::strstr( ( const char* ) multi_boot->cmdline, "elevator=" ) : 0;
+
+  if ( elevator )
+    kernel::driver::IOScheduler::choose( elevator + 9 );
 
   kernel::driver::PCI pci;
 
   pci.scan( true );
 
-  kernel::driver::PCI::DeviceMap::Node* n = pci.devices.find( 0x010180 );
-
-  if ( not n )
-    n = pci.devices.find( 0x01018A );
+  kernel::driver::PCI::Device* device = pci.find( 0x010180 );
 
-  if ( n ) {
-    kernel::driver::PCI::Device* device = n->value;
+  if ( not device )
+    device = pci.find( 0x01018A );
 
-    kernel::driver::ATA* ide = new kernel::driver::ATA( device );
+  if ( device ) {
+    ide = new kernel::driver::ATA( device );
 
 //      kernel::driver::MyFS* myfs = new kernel::driver::MyFS( &ide->drives[ 0 ], 3 );
 //
@@ -100,34 +143,27 @@ void main( MultiBoot* multi_boot ) {
 //      system->video.write( str, len );
 //      system->video << "\n-----";
 
-    kernel::driver::Ext2* ext2 = new kernel::driver::Ext2( &ide->drives[ 0 ], 0 );
-
-    kernel::driver::Ext2::File* r = ext2->root;
-    kernel::driver::fileformat::Elf32 *elf;
+    new kernel::Thread( system, ( uint32 ) &mount, kernel::Thread::DefaultStackSize );
+  }
 
-    if ( r->hasFiles() ) {
-      lib::File::Files* files = r->files();
+  device = pci.find( 0x010601 );
 
-      lib::File::Files::KeyIterator* iter = files->keyIterator();
-      lib::String filename( "PlatinPython" );
+  if ( device ) {
+    system->ahci = new kernel::driver::AHCI( device );
+    system->ahci->coalesce( kernel::driver::AHCI::CoalesceCompletions, kernel::driver::AHCI::CoalesceTimeout );
+  }
 
-      while ( *iter ) {
-        if ( ( **iter )->compare( &filename ) == 0 ) {
-          elf = new kernel::driver::fileformat::Elf32( iter->value() );
-          elf->execute();
-        }
-        ++( *iter );
-      }
+  device = pci.find( 0x010000 );
 
-      delete iter;
-      delete files;
-    }
-  }
+  if ( device && device->config.vendorID == kernel::driver::VirtioBlock::Vendor )
+    system->virtio = new kernel::driver::VirtioBlock( device );
 
   system->video << " -- ";
 
+  kernel::Benchmark::start( multi_boot, ide ? &ide->drives[ 0 ] : 0 );
+
   system->timer.init( kernel::PIT::Mod_RateGenerator );
-  system->timer.load( 6000 );
+  system->timer.load( kernel::PIT::Tick );
   lib::sti();
 
   // at this point our kernel thread is an idle thread!
@@ -0,0 +1,116 @@
+/**
+ * tracedecode.cpp
+ *
+ * Decodes a dump of kernel::Trace on the host.
+ *
+ * g++ -O2 -o tracedecode tools/tracedecode.cpp
+ * ./tracedecode trace.bin
+ *
+ * @since 19.10.2026
+ * @author Arne Simon => email::[arne_simon@gmx.de]
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+#include <stdint.h>
+
+/**
+ * The layout of kernel::Trace::Header and kernel::Trace::Record.
+ */
+struct Header {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t cpus;
+    uint32_t records;
+    uint32_t tsc_khz;
+};
+
+struct Record {
+    uint64_t tsc;
+    uint8_t event;
+    uint8_t cpu;
+    uint16_t a;
+    uint32_t b;
+};
+
+static const uint32_t Magic = 0x43525450;
+static const uint16_t Version = 1;
+
+static const char* Locks[] = { "mutex", "rwlock" };
+
+static bool earlier( const Record& x, const Record& y ) {
+  return x.tsc < y.tsc;
+}
+
+static void print( const Record& r ) {
+  switch ( r.event ) {
+    case 1:
+      printf( "dispatch   %5u -> %u\n", r.a, r.b );
+    break;
+    case 2:
+      printf( "wakeup     %5u -> %u\n", r.a, r.b );
+    break;
+    case 3:
+      printf( "irq enter  0x%02x thread %u\n", r.a, r.b );
+    break;
+    case 4:
+      printf( "irq exit   0x%02x thread %u\n", r.a, r.b );
+    break;
+    case 5:
+      printf( "contended  %s 0x%08x\n", r.a < 2 ? Locks[ r.a ] : "?", r.b );
+    break;
+    default:
+      printf( "unknown    %u %u %u\n", r.event, r.a, r.b );
+    break;
+  }
+}
+
+int main( int argc, char** argv ) {
+  if ( argc != 2 ) {
+    fprintf( stderr, "usage: %s <trace dump>\n", argv[ 0 ] );
+    return 1;
+  }
+
+  FILE* f = fopen( argv[ 1 ], "rb" );
+
+  if ( f == 0 ) {
+    perror( argv[ 1 ] );
+    return 1;
+  }
+
+  Header h;
+
+  if ( fread( &h, sizeof(h), 1, f ) != 1 || h.magic != Magic || h.version != Version ) {
+    fprintf( stderr, "%s: not a trace dump of version %u\n", argv[ 1 ], Version );
+    return 1;
+  }
+
+  std::vector< Record > records( h.records );
+
+  if ( h.records && fread( &records[ 0 ], sizeof(Record), h.records, f ) != h.records ) {
+    fprintf( stderr, "%s: truncated dump\n", argv[ 1 ] );
+    return 1;
+  }
+
+  fclose( f );
+
+  // every cpu is sorted already, merge them by time
+  std::stable_sort( records.begin(), records.end(), earlier );
+
+  printf( "%u records of %u cpus, tsc %u kHz\n", h.records, h.cpus, h.tsc_khz );
+
+  for ( size_t i = 0; i < records.size(); ++i ) {
+    const Record& r = records[ i ];
+    uint64_t delta = r.tsc - records[ 0 ].tsc;
+
+    if ( h.tsc_khz )
+      printf( "%12.3f us  cpu %u  ", delta * 1000.0 / h.tsc_khz, r.cpu );
+    else
+      printf( "%14llu  cpu %u  ", ( unsigned long long ) delta, r.cpu );
+
+    print( r );
+  }
+
+  return 0;
+}